@@ -24,4 +24,34 @@ TEST(Queries, LowestCommonAncestor)
 	EXPECT_EQ('A', LCA.LCA(E, C)->data());
 	EXPECT_EQ('D', LCA.LCA(E, F)->data());
 	EXPECT_EQ('B', LCA.LCA(B, F)->data());
-}
\ No newline at end of file
+}
+
+TEST(Queries, LowestCommonAncestorFlatArrays)
+{
+	// Same tree as above with ids A = 0, B = 1, ..., F = 5, given by parents and by children in CSR form
+	const int parents[] = { -1, 0, 0, 1, 3, 3 };
+	const int child_offsets[] = { 0, 2, 3, 3, 5, 5, 5 };
+	const int children[] = { 1, 2, 3, 4, 5 };
+	Yui::LowestCommonAncestor<> from_parents(parents, 6);
+	Yui::LowestCommonAncestor<> from_children(child_offsets, children, 6, 0);
+	for (const Yui::LowestCommonAncestor<> *LCA : { &from_parents, &from_children })
+	{
+		EXPECT_EQ(0, LCA->LCA(0, 0));
+		EXPECT_EQ(1, LCA->LCA(1, 1));
+		EXPECT_EQ(0, LCA->LCA(0, 5));
+		EXPECT_EQ(1, LCA->LCA(1, 3));
+		EXPECT_EQ(0, LCA->LCA(4, 2));
+		EXPECT_EQ(3, LCA->LCA(4, 5));
+		EXPECT_EQ(1, LCA->LCA(1, 5));
+	}
+
+	// Path of a million nodes: the Euler tour is built without recursion
+	const int kNumNodes = 1000000;
+	std::vector<int> path(kNumNodes);
+	for (int u = 0; u < kNumNodes; ++u)
+		path[u] = u - 1;
+	Yui::LowestCommonAncestor<> deep(&path[0], kNumNodes);
+	EXPECT_EQ(0, deep.LCA(0, kNumNodes - 1));
+	EXPECT_EQ(123456, deep.LCA(123456, 654321));
+	EXPECT_EQ(kNumNodes - 2, deep.LCA(kNumNodes - 1, kNumNodes - 2));
+}
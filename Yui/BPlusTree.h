@@ -0,0 +1,512 @@
+#ifndef __B_PLUS_TREE_H__
+#define __B_PLUS_TREE_H__
+
+// B+tree: ordered container storing the elements in the leaves only, in sorted arrays of up to kLeafCapacity elements, and
+// inner nodes holding up to kInnerCapacity separator keys and kInnerCapacity+1 children. Nodes are NodeBytes bytes large
+// (a few cache lines by default), so a lookup costs one cache-friendly node search per level instead of one cache miss per
+// key as in RBTree and BST, and the tree is only log_B(n) levels deep.
+// - The position of a key in a node is found by counting the keys smaller than it, which is vectorized without branches
+//   for int, float (SSE2) and long long (SSE4.2) keys, and done by binary search otherwise.
+// - Leaves are linked together in both directions, so that range scans walk the leaves sequentially.
+// - Nodes are allocated from Yui::ObjectPool. Duplicate elements are allowed. Elements must be default constructible.
+// Invariant: for a separator key s between children c and c+1, the elements of c are <= s and those of c+1 are >= s.
+#include "ObjectPool.h"
+#include "SortingNetwork.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+namespace Yui
+{
+	namespace BPlusTreeSearch
+	{
+		// Returns the number of keys smaller than e in the sorted array keys
+		template<typename T>
+		inline unsigned int CountLess(const T *keys, unsigned int num_keys, const T &e)
+		{
+			return static_cast<unsigned int>(std::lower_bound(keys, keys + num_keys, e) - keys);
+		}
+
+		// Returns the number of keys smaller than or equal to e in the sorted array keys
+		template<typename T>
+		inline unsigned int CountLessOrEqual(const T *keys, unsigned int num_keys, const T &e)
+		{
+			return static_cast<unsigned int>(std::upper_bound(keys, keys + num_keys, e) - keys);
+		}
+
+#ifdef __SORTING_NETWORK_SIMD
+		// The SIMD versions compare e with every key of the node and sum the comparison masks (-1 per matching lane), which
+		// has no data-dependent branch and is faster than a binary search on the few cache lines of a node.
+		inline unsigned int HorizontalSum(__m128i counts)
+		{
+			counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1, 0, 3, 2)));
+			counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(2, 3, 0, 1)));
+			return static_cast<unsigned int>(-_mm_cvtsi128_si32(counts));
+		}
+
+		inline unsigned int CountLess(const int *keys, unsigned int num_keys, const int &e)
+		{
+			__m128i value = _mm_set1_epi32(e);
+			__m128i counts = _mm_setzero_si128();
+			unsigned int i = 0;
+			for (; i + 4 <= num_keys; i += 4)
+				counts = _mm_add_epi32(counts, _mm_cmplt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)), value));
+			unsigned int count = HorizontalSum(counts);
+			for (; i < num_keys; ++i)
+				count += (keys[i] < e);
+			return count;
+		}
+
+		inline unsigned int CountLessOrEqual(const int *keys, unsigned int num_keys, const int &e)
+		{
+			__m128i value = _mm_set1_epi32(e);
+			__m128i counts = _mm_setzero_si128();
+			unsigned int i = 0;
+			for (; i + 4 <= num_keys; i += 4)
+				counts = _mm_add_epi32(counts, _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)), value));
+			unsigned int count = i - HorizontalSum(counts);
+			for (; i < num_keys; ++i)
+				count += !(e < keys[i]);
+			return count;
+		}
+
+		inline unsigned int CountLess(const float *keys, unsigned int num_keys, const float &e)
+		{
+			__m128 value = _mm_set1_ps(e);
+			__m128i counts = _mm_setzero_si128();
+			unsigned int i = 0;
+			for (; i + 4 <= num_keys; i += 4)
+				counts = _mm_add_epi32(counts, _mm_castps_si128(_mm_cmplt_ps(_mm_loadu_ps(keys + i), value)));
+			unsigned int count = HorizontalSum(counts);
+			for (; i < num_keys; ++i)
+				count += (keys[i] < e);
+			return count;
+		}
+
+		inline unsigned int CountLessOrEqual(const float *keys, unsigned int num_keys, const float &e)
+		{
+			__m128 value = _mm_set1_ps(e);
+			__m128i counts = _mm_setzero_si128();
+			unsigned int i = 0;
+			for (; i + 4 <= num_keys; i += 4)
+				counts = _mm_add_epi32(counts, _mm_castps_si128(_mm_cmple_ps(_mm_loadu_ps(keys + i), value)));
+			unsigned int count = HorizontalSum(counts);
+			for (; i < num_keys; ++i)
+				count += !(e < keys[i]);
+			return count;
+		}
+
+		// 64-bit comparisons require SSE4.2. The counts of the two lanes are accumulated as 64-bit integers.
+		__SORTING_NETWORK_SSE42 inline unsigned int CountGreaterInt64(const long long *keys, unsigned int num_keys, const long long &e,
+			bool greater)
+		{
+			__m128i value = _mm_set1_epi64x(e);
+			__m128i counts = _mm_setzero_si128();
+			unsigned int i = 0;
+			for (; i + 2 <= num_keys; i += 2)
+			{
+				__m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+				counts = _mm_add_epi64(counts, greater ? _mm_cmpgt_epi64(key, value) : _mm_cmpgt_epi64(value, key));
+			}
+			long long lane_counts[2];
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(lane_counts), counts);
+			unsigned int count = static_cast<unsigned int>(-(lane_counts[0] + lane_counts[1]));
+			for (; i < num_keys; ++i)
+				count += (greater ? e < keys[i] : keys[i] < e);
+			return count;
+		}
+
+		inline unsigned int CountLess(const long long *keys, unsigned int num_keys, const long long &e)
+		{
+			if (!SortingNetwork::HasSSE42())
+				return static_cast<unsigned int>(std::lower_bound(keys, keys + num_keys, e) - keys);
+			return CountGreaterInt64(keys, num_keys, e, false);
+		}
+
+		inline unsigned int CountLessOrEqual(const long long *keys, unsigned int num_keys, const long long &e)
+		{
+			if (!SortingNetwork::HasSSE42())
+				return static_cast<unsigned int>(std::upper_bound(keys, keys + num_keys, e) - keys);
+			return num_keys - CountGreaterInt64(keys, num_keys, e, true);
+		}
+#endif
+	};
+
+	template<typename Element, unsigned int NodeBytes = 256>
+	class BPlusTree
+	{
+	public:
+		// Number of elements of a leaf and of separator keys of an inner node, such that a node fits in NodeBytes bytes
+		static const unsigned int kLeafCapacity = ((NodeBytes - 2 * sizeof(void *) - 2 * sizeof(unsigned int)) / sizeof(Element) > 3 ?
+			static_cast<unsigned int>((NodeBytes - 2 * sizeof(void *) - 2 * sizeof(unsigned int)) / sizeof(Element)) : 3);
+		static const unsigned int kInnerCapacity = ((NodeBytes - sizeof(void *) - 2 * sizeof(unsigned int)) / (sizeof(Element) + sizeof(void *)) > 3 ?
+			static_cast<unsigned int>((NodeBytes - sizeof(void *) - 2 * sizeof(unsigned int)) / (sizeof(Element) + sizeof(void *))) : 3);
+
+	private:
+		// Nodes other than the root never hold less than these numbers of keys
+		static const unsigned int kMinLeafKeys = kLeafCapacity / 2;
+		static const unsigned int kMinInnerKeys = (kInnerCapacity - 1) / 2;
+
+		struct Node
+		{
+			unsigned int num_keys_ = 0;
+			bool is_leaf_;
+			explicit Node(bool is_leaf) : is_leaf_(is_leaf)	{}
+		};
+
+		struct LeafNode : public Node
+		{
+			LeafNode *previous_ = nullptr;
+			LeafNode *next_ = nullptr;
+			Element keys_[kLeafCapacity];
+			LeafNode() : Node(true)	{}
+		};
+
+		struct InnerNode : public Node
+		{
+			Element keys_[kInnerCapacity];
+			Node *children_[kInnerCapacity + 1];
+			InnerNode() : Node(false)	{}
+		};
+
+		ObjectPool<LeafNode> leaf_pool_;
+		ObjectPool<InnerNode> inner_pool_;
+		Node *root_ = nullptr;
+		LeafNode *first_leaf_ = nullptr;
+		LeafNode *last_leaf_ = nullptr;
+		size_t size_ = 0;
+
+		static inline LeafNode *AsLeaf(Node *n)	{ return static_cast<LeafNode *>(n); }
+		static inline InnerNode *AsInner(Node *n)	{ return static_cast<InnerNode *>(n); }
+
+		// Returns the leaf and the position of the first element >= e, or a null leaf if there is none
+		std::pair<LeafNode *, unsigned int> LowerBound(const Element &e)	const
+		{
+			if (!root_)
+				return std::make_pair(nullptr, 0u);
+			Node *n = root_;
+			while (!n->is_leaf_)
+				n = AsInner(n)->children_[BPlusTreeSearch::CountLess(AsInner(n)->keys_, n->num_keys_, e)];
+			LeafNode *leaf = AsLeaf(n);
+			unsigned int position = BPlusTreeSearch::CountLess(leaf->keys_, leaf->num_keys_, e);
+			// The next leaf may start with e when the separator is equal to e
+			if (position == leaf->num_keys_)
+				return std::make_pair(leaf->next_, 0u);
+			return std::make_pair(leaf, position);
+		}
+
+		// Inserts e in the subtree n. If n was split, returns the new right node and sets split_key to its separator.
+		Node *InternalInsert(Node *n, const Element &e, Element &split_key)
+		{
+			if (n->is_leaf_)
+			{
+				LeafNode *leaf = AsLeaf(n);
+				unsigned int position = BPlusTreeSearch::CountLessOrEqual(leaf->keys_, leaf->num_keys_, e);
+				LeafNode *right = nullptr;
+				if (leaf->num_keys_ == kLeafCapacity)
+				{
+					// Move the upper half of the leaf to a new leaf
+					right = leaf_pool_.New();
+					unsigned int left_size = kLeafCapacity - kLeafCapacity / 2;
+					std::move(leaf->keys_ + left_size, leaf->keys_ + kLeafCapacity, right->keys_);
+					right->num_keys_ = kLeafCapacity - left_size;
+					leaf->num_keys_ = left_size;
+					right->previous_ = leaf;
+					right->next_ = leaf->next_;
+					if (leaf->next_)
+						leaf->next_->previous_ = right;
+					else
+						last_leaf_ = right;
+					leaf->next_ = right;
+					if (position > left_size)
+					{
+						position -= left_size;
+						leaf = right;
+					}
+				}
+				std::move_backward(leaf->keys_ + position, leaf->keys_ + leaf->num_keys_, leaf->keys_ + leaf->num_keys_ + 1);
+				leaf->keys_[position] = e;
+				++leaf->num_keys_;
+				if (right)
+					split_key = right->keys_[0];
+				return right;
+			}
+
+			InnerNode *inner = AsInner(n);
+			unsigned int child = BPlusTreeSearch::CountLessOrEqual(inner->keys_, inner->num_keys_, e);
+			Element child_split_key;
+			Node *new_child = InternalInsert(inner->children_[child], e, child_split_key);
+			if (!new_child)
+				return nullptr;
+			InnerNode *right = nullptr;
+			if (inner->num_keys_ == kInnerCapacity)
+			{
+				// The middle key moves up to the parent, the keys and children on its right move to a new node
+				right = inner_pool_.New();
+				unsigned int middle = kInnerCapacity / 2;
+				split_key = inner->keys_[middle];
+				std::move(inner->keys_ + middle + 1, inner->keys_ + kInnerCapacity, right->keys_);
+				std::copy(inner->children_ + middle + 1, inner->children_ + kInnerCapacity + 1, right->children_);
+				right->num_keys_ = kInnerCapacity - middle - 1;
+				inner->num_keys_ = middle;
+				if (child > middle)
+				{
+					child -= middle + 1;
+					inner = right;
+				}
+			}
+			std::move_backward(inner->keys_ + child, inner->keys_ + inner->num_keys_, inner->keys_ + inner->num_keys_ + 1);
+			std::copy_backward(inner->children_ + child + 1, inner->children_ + inner->num_keys_ + 1, inner->children_ + inner->num_keys_ + 2);
+			inner->keys_[child] = std::move(child_split_key);
+			inner->children_[child + 1] = new_child;
+			++inner->num_keys_;
+			return right;
+		}
+
+		// Removes the separator at 'position' and the child on its right from inner
+		static void RemoveSeparator(InnerNode *inner, unsigned int position)
+		{
+			std::move(inner->keys_ + position + 1, inner->keys_ + inner->num_keys_, inner->keys_ + position);
+			std::copy(inner->children_ + position + 2, inner->children_ + inner->num_keys_ + 1, inner->children_ + position + 1);
+			--inner->num_keys_;
+		}
+
+		// Restores the minimum number of keys of the child at 'position' of parent, by borrowing a key from a sibling or
+		// by merging it with a sibling
+		void FixUnderflow(InnerNode *parent, unsigned int position)
+		{
+			Node *n = parent->children_[position];
+			Node *left = (position > 0 ? parent->children_[position - 1] : nullptr);
+			Node *right = (position < parent->num_keys_ ? parent->children_[position + 1] : nullptr);
+			if (n->is_leaf_)
+			{
+				LeafNode *leaf = AsLeaf(n);
+				if (left && left->num_keys_ > kMinLeafKeys)
+				{
+					LeafNode *left_leaf = AsLeaf(left);
+					std::move_backward(leaf->keys_, leaf->keys_ + leaf->num_keys_, leaf->keys_ + leaf->num_keys_ + 1);
+					leaf->keys_[0] = std::move(left_leaf->keys_[--left_leaf->num_keys_]);
+					++leaf->num_keys_;
+					parent->keys_[position - 1] = leaf->keys_[0];
+				}
+				else if (right && right->num_keys_ > kMinLeafKeys)
+				{
+					LeafNode *right_leaf = AsLeaf(right);
+					leaf->keys_[leaf->num_keys_++] = std::move(right_leaf->keys_[0]);
+					std::move(right_leaf->keys_ + 1, right_leaf->keys_ + right_leaf->num_keys_, right_leaf->keys_);
+					--right_leaf->num_keys_;
+					parent->keys_[position] = right_leaf->keys_[0];
+				}
+				else
+				{
+					// Merge the right node of the pair into the left one
+					if (left)
+					{
+						--position;
+						right = leaf;
+						leaf = AsLeaf(left);
+					}
+					LeafNode *right_leaf = AsLeaf(right);
+					std::move(right_leaf->keys_, right_leaf->keys_ + right_leaf->num_keys_, leaf->keys_ + leaf->num_keys_);
+					leaf->num_keys_ += right_leaf->num_keys_;
+					leaf->next_ = right_leaf->next_;
+					if (leaf->next_)
+						leaf->next_->previous_ = leaf;
+					else
+						last_leaf_ = leaf;
+					leaf_pool_.Delete(right_leaf);
+					RemoveSeparator(parent, position);
+				}
+				return;
+			}
+
+			InnerNode *inner = AsInner(n);
+			if (left && left->num_keys_ > kMinInnerKeys)
+			{
+				// Rotate the last child of left through the parent
+				InnerNode *left_inner = AsInner(left);
+				std::move_backward(inner->keys_, inner->keys_ + inner->num_keys_, inner->keys_ + inner->num_keys_ + 1);
+				std::copy_backward(inner->children_, inner->children_ + inner->num_keys_ + 1, inner->children_ + inner->num_keys_ + 2);
+				inner->keys_[0] = std::move(parent->keys_[position - 1]);
+				inner->children_[0] = left_inner->children_[left_inner->num_keys_];
+				++inner->num_keys_;
+				parent->keys_[position - 1] = std::move(left_inner->keys_[--left_inner->num_keys_]);
+			}
+			else if (right && right->num_keys_ > kMinInnerKeys)
+			{
+				// Rotate the first child of right through the parent
+				InnerNode *right_inner = AsInner(right);
+				inner->keys_[inner->num_keys_] = std::move(parent->keys_[position]);
+				inner->children_[inner->num_keys_ + 1] = right_inner->children_[0];
+				++inner->num_keys_;
+				parent->keys_[position] = std::move(right_inner->keys_[0]);
+				std::move(right_inner->keys_ + 1, right_inner->keys_ + right_inner->num_keys_, right_inner->keys_);
+				std::copy(right_inner->children_ + 1, right_inner->children_ + right_inner->num_keys_ + 1, right_inner->children_);
+				--right_inner->num_keys_;
+			}
+			else
+			{
+				// Merge the right node of the pair and the separator into the left node
+				if (left)
+				{
+					--position;
+					right = inner;
+					inner = AsInner(left);
+				}
+				InnerNode *right_inner = AsInner(right);
+				inner->keys_[inner->num_keys_] = std::move(parent->keys_[position]);
+				std::move(right_inner->keys_, right_inner->keys_ + right_inner->num_keys_, inner->keys_ + inner->num_keys_ + 1);
+				std::copy(right_inner->children_, right_inner->children_ + right_inner->num_keys_ + 1, inner->children_ + inner->num_keys_ + 1);
+				inner->num_keys_ += right_inner->num_keys_ + 1;
+				inner_pool_.Delete(right_inner);
+				RemoveSeparator(parent, position);
+			}
+		}
+
+		// Removes one element equal to e from the subtree n. Returns false if there is none.
+		bool InternalDelete(Node *n, const Element &e)
+		{
+			if (n->is_leaf_)
+			{
+				LeafNode *leaf = AsLeaf(n);
+				unsigned int position = BPlusTreeSearch::CountLess(leaf->keys_, leaf->num_keys_, e);
+				if (position == leaf->num_keys_ || e < leaf->keys_[position])
+					return false;
+				std::move(leaf->keys_ + position + 1, leaf->keys_ + leaf->num_keys_, leaf->keys_ + position);
+				--leaf->num_keys_;
+				return true;
+			}
+
+			InnerNode *inner = AsInner(n);
+			// With duplicates, the elements equal to e may continue in the next children as long as the separators equal e
+			for (unsigned int child = BPlusTreeSearch::CountLess(inner->keys_, inner->num_keys_, e); child <= inner->num_keys_; ++child)
+			{
+				if (InternalDelete(inner->children_[child], e))
+				{
+					Node *c = inner->children_[child];
+					if (c->is_leaf_ ? c->num_keys_ < kMinLeafKeys : c->num_keys_ < kMinInnerKeys)
+						FixUnderflow(inner, child);
+					return true;
+				}
+				if (child == inner->num_keys_ || e < inner->keys_[child])
+					break;
+			}
+			return false;
+		}
+
+		void Destroy(Node *n)
+		{
+			if (n->is_leaf_)
+				leaf_pool_.Delete(AsLeaf(n));
+			else
+			{
+				InnerNode *inner = AsInner(n);
+				for (unsigned int i = 0; i <= inner->num_keys_; ++i)
+					Destroy(inner->children_[i]);
+				inner_pool_.Delete(inner);
+			}
+		}
+
+	public:
+		BPlusTree()	{}
+		~BPlusTree()	{ Clear(); }
+
+		BPlusTree(const BPlusTree &) = delete;
+		BPlusTree &operator=(const BPlusTree &) = delete;
+
+		// O(log n) worst case time complexity
+		void Insert(const Element &e)
+		{
+			if (!root_)
+			{
+				first_leaf_ = last_leaf_ = leaf_pool_.New();
+				root_ = first_leaf_;
+			}
+			Element split_key;
+			Node *right = InternalInsert(root_, e, split_key);
+			if (right)
+			{
+				// The tree grows from the root
+				InnerNode *root = inner_pool_.New();
+				root->keys_[0] = std::move(split_key);
+				root->children_[0] = root_;
+				root->children_[1] = right;
+				root->num_keys_ = 1;
+				root_ = root;
+			}
+			++size_;
+		}
+
+		// Returns a pointer to an element equal to 'e', or nullptr if there is none. O(log n)
+		const Element *Find(const Element &e)	const
+		{
+			std::pair<LeafNode *, unsigned int> position = LowerBound(e);
+			if (!position.first || e < position.first->keys_[position.second])
+				return nullptr;
+			return &position.first->keys_[position.second];
+		}
+
+		// Removes one element equal to 'e'. Returns false if there is none. O(log n)
+		bool Delete(const Element &e)
+		{
+			if (!root_ || !InternalDelete(root_, e))
+				return false;
+			--size_;
+			// The tree shrinks from the root
+			if (!root_->is_leaf_ && root_->num_keys_ == 0)
+			{
+				InnerNode *root = AsInner(root_);
+				root_ = root->children_[0];
+				inner_pool_.Delete(root);
+			}
+			else if (root_->is_leaf_ && root_->num_keys_ == 0)
+			{
+				leaf_pool_.Delete(AsLeaf(root_));
+				root_ = nullptr;
+				first_leaf_ = last_leaf_ = nullptr;
+			}
+			return true;
+		}
+
+		// Calls fn(e) for each element e such that lo <= e <= hi, in increasing order. O(log n + k) where k is the number of
+		// elements in the range.
+		template<typename F>
+		void ForEachInRange(const Element &lo, const Element &hi, F fn)	const
+		{
+			std::pair<LeafNode *, unsigned int> position = LowerBound(lo);
+			for (LeafNode *leaf = position.first; leaf; leaf = leaf->next_)
+			{
+				for (unsigned int i = position.second; i < leaf->num_keys_; ++i)
+				{
+					if (hi < leaf->keys_[i])
+						return;
+					fn(leaf->keys_[i]);
+				}
+				position.second = 0;
+			}
+		}
+
+		void Clear()
+		{
+			if (root_)
+				Destroy(root_);
+			leaf_pool_.Clear();
+			inner_pool_.Clear();
+			root_ = nullptr;
+			first_leaf_ = last_leaf_ = nullptr;
+			size_ = 0;
+		}
+
+		// Returns the minimum element in constant time, or nullptr if the tree is empty
+		inline const Element *GetMin()	const	{ return (first_leaf_ ? &first_leaf_->keys_[0] : nullptr); }
+		// Returns the maximum element in constant time, or nullptr if the tree is empty
+		inline const Element *GetMax()	const	{ return (last_leaf_ ? &last_leaf_->keys_[last_leaf_->num_keys_ - 1] : nullptr); }
+		inline size_t Size()	const	{ return size_; }
+		inline bool IsEmpty()	const	{ return size_ == 0; }
+		// Memory used by the nodes
+		inline size_t AllocatedBytes()	const	{ return leaf_pool_.AllocatedBytes() + inner_pool_.AllocatedBytes(); }
+	};
+};
+
+#endif
@@ -2,19 +2,101 @@
 #include <map>
 #include <list>
 #include <stack>
+#include <vector>
+#include <iterator>
+#include <stddef.h>
+#include <stdint.h>
 
 namespace Yui
 {
-	// Non-balanced binary search tree
-	template<typename Element>
+	// Balancing policies of BST and CompactBST. A policy provides the NodeData stored in every node and restores the balance
+	// after an insertion (AfterInsert, from the inserted node) and a deletion (AfterDelete, from the lowest node whose subtree
+	// lost a node). Nodes are handles (pointers in BST, indices in CompactBST) that evaluate to false when null, and are
+	// accessed through the tree's Left, Right, Parent, Data, RotateLeft and RotateRight. Rotations do not change the in-order
+	// sequence, so the predecessor/successor threads and min/max are left untouched.
+
+	// Default policy: no rebalancing, sorted insertions degenerate the tree into a list
+	struct BSTNoBalancing
+	{
+		struct NodeData	{};
+
+		template<typename Tree, typename Handle>
+		static inline void AfterInsert(Tree &, Handle)	{}
+		template<typename Tree, typename Handle>
+		static inline void AfterDelete(Tree &, Handle)	{}
+	};
+
+	// AVL tree: the heights of the two subtrees of any node differ by at most one, so the height is below 1.44 log2(n).
+	// Insertion and deletion rebalance with at most two rotations per level on the path to the root.
+	struct BSTAVLBalancing
+	{
+		struct NodeData
+		{
+			int height_ = 1;
+		};
+
+		template<typename Tree, typename Handle>
+		static inline int Height(Tree &tree, Handle n)	{ return n ? tree.Data(n).height_ : 0; }
+		template<typename Tree, typename Handle>
+		static inline void UpdateHeight(Tree &tree, Handle n)	{ tree.Data(n).height_ = 1 + std::max(Height(tree, tree.Left(n)), Height(tree, tree.Right(n))); }
+
+		template<typename Tree, typename Handle>
+		static void Rebalance(Tree &tree, Handle n)
+		{
+			while (n)
+			{
+				UpdateHeight(tree, n);
+				int balance = Height(tree, tree.Left(n)) - Height(tree, tree.Right(n));
+				if (balance > 1)
+				{
+					// Left-right case: bring the heavier grandchild on the left first
+					Handle left = tree.Left(n);
+					if (Height(tree, tree.Left(left)) < Height(tree, tree.Right(left)))
+					{
+						tree.RotateLeft(left);
+						UpdateHeight(tree, left);
+					}
+					tree.RotateRight(n);
+					UpdateHeight(tree, n);
+					n = tree.Parent(n);
+					UpdateHeight(tree, n);
+				}
+				else if (balance < -1)
+				{
+					Handle right = tree.Right(n);
+					if (Height(tree, tree.Right(right)) < Height(tree, tree.Left(right)))
+					{
+						tree.RotateRight(right);
+						UpdateHeight(tree, right);
+					}
+					tree.RotateLeft(n);
+					UpdateHeight(tree, n);
+					n = tree.Parent(n);
+					UpdateHeight(tree, n);
+				}
+				n = tree.Parent(n);
+			}
+		}
+
+		template<typename Tree, typename Handle>
+		static inline void AfterInsert(Tree &tree, Handle n)	{ Rebalance(tree, tree.Parent(n)); }
+		template<typename Tree, typename Handle>
+		static inline void AfterDelete(Tree &tree, Handle n)	{ Rebalance(tree, n); }
+	};
+
+	// Binary search tree, balanced according to the Balancing policy (not balanced by default). The nodes are threaded in a
+	// doubly linked list through their predecessor and successor.
+	template<typename Element, typename Balancing = BSTNoBalancing>
 	class BST
 	{
+		friend Balancing;
+
 	public:
 		// Nodes hold pointers on data objects of type Element
 		template<typename Element>
-		class Node
+		class Node : public Balancing::NodeData
 		{
-			friend class BST < Element > ;
+			friend class BST < Element, Balancing > ;
 
 		private:
 			Element data_;
@@ -42,170 +124,128 @@ namespace Yui
 		Node<Element> *min_ = nullptr;
 		Node<Element> *max_ = nullptr;
 
+		typedef typename Balancing::NodeData NodeData;
+
+		// Accessors of the balancing policy
+		static inline Node<Element> *Left(Node<Element> *n)	{ return n->left(); }
+		static inline Node<Element> *Right(Node<Element> *n)	{ return n->right(); }
+		static inline Node<Element> *Parent(Node<Element> *n)	{ return n->parent(); }
+		static inline NodeData &Data(Node<Element> *n)	{ return *n; }
+
+		// A node without predecessor is the min and a node without successor is the max
 		void UpdateMinMax(Node<Element> *n)
 		{
-			if (!min_)
-			{
+			if (!n->predecessor())
 				min_ = n;
+			if (!n->successor())
 				max_ = n;
+		}
+
+		// Update the predecessor and successor of the new leaf n in constant time: a left child is the predecessor of its parent,
+		// a right child its successor
+		void UpdatePredecessorAndSuccessor(Node<Element> *n)
+		{
+			Node<Element> *parent = n->parent();
+			if (!parent)
+				return;
+			if (parent->left() == n)
+			{
+				// Insert n between parent->predecessor() and parent
+				n->predecessor_ = parent->predecessor();
+				n->successor_ = parent;
+				if (parent->predecessor())
+					parent->predecessor()->successor_ = n;
+				parent->predecessor_ = n;
 			}
 			else
 			{
-				if (n->data() < min_->data())
-					min_ = n;
-				if (n->data() > max_->data())
-					max_ = n;
+				// Insert n between parent and parent->successor()
+				n->predecessor_ = parent;
+				n->successor_ = parent->successor();
+				if (parent->successor())
+					parent->successor()->predecessor_ = n;
+				parent->successor_ = n;
 			}
 		}
 
-		// Find n's predecessor in log(h) time
-		Node<Element> *FindPredecessor(Node<Element> * n)
+		// Replaces the child 'child' of 'parent' (the root if parent is nullptr) by 'replacement'
+		void ReplaceChild(Node<Element> *parent, Node<Element> *child, Node<Element> *replacement)
 		{
-			if (n->left())
-				return GetMax(n->left());
+			if (!parent)
+				root_ = replacement;
+			else if (parent->left() == child)
+				parent->left_ = replacement;
 			else
-			{
-				Node<Element> *child = n;
-				Node<Element> *parent = n->parent();
-				while (parent)
-				{
-					if (parent->right() == child)
-						return parent;
-					child = parent;
-					parent = parent->parent();
-				}
-				return parent;
-			}
+				parent->right_ = replacement;
 		}
 
-		// Find n's successor in log(h) time
-		Node<Element> *FindSuccessor(Node<Element> * n)
+		// Rotates n with its right child, which takes its place. Returns the new root of the subtree.
+		Node<Element> *RotateLeft(Node<Element> *n)
 		{
-			if (n->right())
-				return GetMin(n->right());
-			else
-			{
-				Node<Element> *child = n;
-				Node<Element> *parent = n->parent();
-				while (parent)
-				{
-					if (parent->left() == child)
-						return parent;
-					child = parent;
-					parent = parent->parent();
-				}
-				return parent;
-			}
+			Node<Element> *r = n->right();
+			n->right_ = r->left();
+			if (r->left())
+				r->left()->parent_ = n;
+			r->parent_ = n->parent();
+			ReplaceChild(n->parent(), n, r);
+			r->left_ = n;
+			n->parent_ = r;
+			return r;
 		}
 
-		// Update n's predecessor and successor in log(h) time
-		void UpdatePredecessorAndSuccessor(Node<Element> *n)
+		// Rotates n with its left child, which takes its place. Returns the new root of the subtree.
+		Node<Element> *RotateRight(Node<Element> *n)
 		{
-			Node<Element> *predecessor = FindPredecessor(n);
-			if (predecessor)
-			{
-				// Insert n between predecessor and predecessor->successor()
-				if (predecessor->successor())
-				{
-					predecessor->successor()->predecessor_ = n;
-					n->successor_ = predecessor->successor();
-				}
-				predecessor->successor_ = n;
-				n->predecessor_ = predecessor;
-			}
-			else
-			{
-				Node<Element> *successor = FindSuccessor(n);
-				// Insert n between successor->predecessor() and successor
-				if (successor)
-				{
-					if (successor->predecessor())
-					{
-						successor->predecessor()->successor_ = n;
-						n->predecessor_ = successor->predecessor();
-					}
-					successor->predecessor_ = n;
-					n->successor_ = successor;
-				}
-			}
+			Node<Element> *l = n->left();
+			n->left_ = l->right();
+			if (l->right())
+				l->right()->parent_ = n;
+			l->parent_ = n->parent();
+			ReplaceChild(n->parent(), n, l);
+			l->right_ = n;
+			n->parent_ = l;
+			return l;
 		}
 
-		void InternalDelete(Node<Element> *n)
+		// Removes n from the tree and from the successor/predecessor list. Returns the lowest node whose subtree lost a node,
+		// from which the balance must be restored.
+		Node<Element> *InternalDelete(Node<Element> *n)
 		{
 			Node<Element> *n_parent = n->parent();
+			Node<Element> *lowest;
 			// Case 1: n has 2 children
-			// Replace n with the minimum element from the subtree whose root is n->right()
+			// Replace n with its successor, the minimum element from the subtree whose root is n->right()
 			if (n->left() && n->right())
 			{
-				Node<Element> *min = GetMin(n->right());	// min can't be nullptr
-				InternalDelete(min);	// min->left() and min->right() are nullptr, see case 4
-				// Replace n with min
-				min->parent_ = n_parent;
-				min->left_ = n->left();
-				min->right_ = n->right();
-				// Update min's children
-				if (min->left())
-					min->left()->parent_ = min;
-				if (min->right())
-					min->right()->parent_ = min;
-
-				if (n_parent)
-				{
-					if (n_parent->left() == n)
-						n_parent->left_ = min;
-					else
-						n_parent->right_ = min;
-				}
-				// n is the root
-				else
-					root_ = min;
-			}
-			// Case 2: n only has a left child
-			// Replace n with n->left()
-			else if (n->left() && !n->right())
-			{
-				Node<Element> *n_left = n->left();
-				// Update n_left
-				n_left->parent_ = n_parent;
-				if (n_parent)
-				{
-					if (n_parent->left() == n)
-						n_parent->left_ = n_left;
-					else
-						n_parent->right_ = n_left;
-				}
-				else
-					root_ = n_left;
-			}
-			// Case 3: n only has a right child
-			// Replace n with n->right()
-			else if (!n->left() && n->right())
-			{
-				Node<Element> *n_right = n->right();
-				// Update n_right
-				n_right->parent_ = n_parent;
-				if (n_parent)
+				Node<Element> *min = n->successor();
+				// Detach min, which has no left child
+				if (min->parent() != n)
 				{
-					if (n_parent->left() == n)
-						n_parent->left_ = n_right;
-					else
-						n_parent->right_ = n_right;
+					lowest = min->parent();
+					ReplaceChild(min->parent(), min, min->right());
+					if (min->right())
+						min->right()->parent_ = min->parent();
+					min->right_ = n->right();
+					min->right()->parent_ = min;
 				}
 				else
-					root_ = n_right;
+					lowest = min;
+				// Replace n with min
+				min->left_ = n->left();
+				min->left()->parent_ = min;
+				min->parent_ = n_parent;
+				ReplaceChild(n_parent, n, min);
+				static_cast<NodeData &>(*min) = static_cast<const NodeData &>(*n);
 			}
-			// Case 4: n has no children
+			// Case 2: n has at most one child
+			// Replace n with its child
 			else
 			{
-				if (n_parent)
-				{
-					if (n_parent->left() == n)
-						n_parent->left_ = nullptr;
-					else
-						n_parent->right_ = nullptr;
-				}
-				else
-					root_ = nullptr;
+				Node<Element> *child = n->left() ? n->left() : n->right();
+				if (child)
+					child->parent_ = n_parent;
+				ReplaceChild(n_parent, n, child);
+				lowest = n_parent;
 			}
 
 			// Remove n from the successor/predecessor doubly linked list 
@@ -213,9 +253,16 @@ namespace Yui
 				n->predecessor_->successor_ = n->successor_;
 			if (n->successor_)
 				n->successor_->predecessor_ = n->predecessor_;
+			return lowest;
 		}
 
 	public:
+		BST()	{}
+		~BST()	{ Clear(); }
+
+		BST(const BST &) = delete;
+		BST &operator=(const BST &) = delete;
+
 		void Insert(const Element &e)
 		{
 			Node<Element> **n = &root_;
@@ -231,9 +278,10 @@ namespace Yui
 				else
 					n = &((*n)->right_);
 			}
-			*n = new Node<Element>(e, parent);
-			UpdatePredecessorAndSuccessor(*n);
-			UpdateMinMax(*n);
+			Node<Element> *new_node = *n = new Node<Element>(e, parent);
+			UpdatePredecessorAndSuccessor(new_node);
+			UpdateMinMax(new_node);
+			Balancing::AfterInsert(*this, new_node);
 		}
 
 		void Insert(const Element &&e)
@@ -251,9 +299,10 @@ namespace Yui
 				else
 					n = &((*n)->right_);
 			}
-			*n = new Node<Element>(std::move(e), parent);
-			UpdatePredecessorAndSuccessor(*n);
-			UpdateMinMax(*n);
+			Node<Element> *new_node = *n = new Node<Element>(std::move(e), parent);
+			UpdatePredecessorAndSuccessor(new_node);
+			UpdateMinMax(new_node);
+			Balancing::AfterInsert(*this, new_node);
 		}
 
 		// Returns the node whose value is 'e', or nullptr if the node could not be found. Non-recursive. log(h) time complexity
@@ -277,14 +326,30 @@ namespace Yui
 
 		void Delete(Node<Element> *n)
 		{
-			InternalDelete(n);
+			Node<Element> *lowest = InternalDelete(n);
 
 			// Update min_ and max_
-			if (min_->data() == n->data())
+			if (min_ == n)
 				min_ = n->successor();
-			if (max_->data() == n->data())
+			if (max_ == n)
 				max_ = n->predecessor();
 			delete n;
+			Balancing::AfterDelete(*this, lowest);
+		}
+
+		// Deletes all the nodes in linear time along the successor list
+		void Clear()
+		{
+			Node<Element> *n = min_;
+			while (n)
+			{
+				Node<Element> *successor = n->successor();
+				delete n;
+				n = successor;
+			}
+			root_ = nullptr;
+			min_ = nullptr;
+			max_ = nullptr;
 		}
 
 		// Returns the node whose value is minimum in the subtree whose 'root' is passed as argument
@@ -309,24 +374,45 @@ namespace Yui
 			return n;
 		}
 
-		// Performs in order traversal of the BST and returns a sorted doubly linked list of the nodes.
-		// Non recursive.
-		void ConvertToList(std::list<Element> &list)
+		// Forward iterator along the successor list: in-order traversal in constant time per step, without copy nor stack
+		class Iterator
 		{
-			std::stack<Node<Element> *> stack;
-			Node<Element> *current_node = root_;
-			while (current_node || !stack.empty())
+		private:
+			const Node<Element> *node_;
+
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef Element value_type;
+			typedef ptrdiff_t difference_type;
+			typedef const Element *pointer;
+			typedef const Element &reference;
+
+			explicit Iterator(const Node<Element> *n = nullptr) : node_(n)	{}
+
+			inline reference operator*()	const	{ return node_->data(); }
+			inline pointer operator->()	const	{ return &node_->data(); }
+			inline Iterator &operator++()
 			{
-				while (current_node)
-				{
-					stack.push(current_node);
-					current_node = current_node->left();
-				}
-				Node<Element> *n = stack.top();
-				stack.pop();
-				list.push_back(n->data());
-				current_node = n->right();
+				node_ = node_->successor();
+				return *this;
+			}
+			inline Iterator operator++(int)
+			{
+				Iterator it = *this;
+				node_ = node_->successor();
+				return it;
 			}
+			inline bool operator==(const Iterator &other)	const	{ return node_ == other.node_; }
+			inline bool operator!=(const Iterator &other)	const	{ return node_ != other.node_; }
+		};
+
+		inline Iterator begin()	const	{ return Iterator(min_); }
+		inline Iterator end()	const	{ return Iterator(); }
+
+		// Copies the elements in increasing order into a list. Prefer iterating from begin() to end(), which copies nothing.
+		void ConvertToList(std::list<Element> &list)
+		{
+			list.insert(list.end(), begin(), end());
 		}
 
 		inline Node<Element> *root()	{ return root_; }
@@ -335,4 +421,282 @@ namespace Yui
 		// Returns the max element in constant time
 		inline Node<Element> *max()	{ return max_; }
 	};
+
+	// Binary search tree storing its nodes in a contiguous vector and linking them with 32-bit indices instead of pointers,
+	// with the same predecessor/successor threads, constant time min/max and Balancing policies as BST. A node of an int
+	// tree takes 24 bytes instead of 48, nodes allocated together are contiguous in memory, and the slots of deleted nodes
+	// are reused through a free list. Nodes are designated by their index, which stays valid until the node is deleted
+	// (unlike pointers to elements, which the growth of the vector invalidates). Index 0 is reserved as the null index.
+	template<typename Element, typename Balancing = BSTNoBalancing>
+	class CompactBST
+	{
+		friend Balancing;
+
+	public:
+		typedef uint32_t Index;
+		static const Index kNull = 0;
+
+	private:
+		struct Node : public Balancing::NodeData
+		{
+			Element data_;
+			Index left_ = kNull;
+			Index right_ = kNull;
+			Index parent_;
+			// Next free slot when the node is in the free list
+			Index successor_ = kNull;
+			Index predecessor_ = kNull;
+
+			Node() : data_(), parent_(kNull)	{}
+			Node(const Element &e, Index parent) : data_(e), parent_(parent)	{}
+		};
+
+		typedef typename Balancing::NodeData NodeData;
+
+		std::vector<Node> nodes_;
+		Index root_ = kNull;
+		Index min_ = kNull;
+		Index max_ = kNull;
+		Index free_list_ = kNull;
+		size_t size_ = 0;
+
+		// Accessors of the balancing policy
+		inline Index Left(Index n)	const	{ return nodes_[n].left_; }
+		inline Index Right(Index n)	const	{ return nodes_[n].right_; }
+		inline Index Parent(Index n)	const	{ return nodes_[n].parent_; }
+		inline NodeData &Data(Index n)	{ return nodes_[n]; }
+
+		Index NewNode(const Element &e, Index parent)
+		{
+			if (nodes_.empty())
+				nodes_.push_back(Node());
+			if (free_list_ == kNull)
+			{
+				nodes_.push_back(Node(e, parent));
+				return Index(nodes_.size() - 1);
+			}
+			Index n = free_list_;
+			free_list_ = nodes_[n].successor_;
+			nodes_[n] = Node(e, parent);
+			return n;
+		}
+
+		void ReplaceChild(Index parent, Index child, Index replacement)
+		{
+			if (parent == kNull)
+				root_ = replacement;
+			else if (nodes_[parent].left_ == child)
+				nodes_[parent].left_ = replacement;
+			else
+				nodes_[parent].right_ = replacement;
+		}
+
+		Index RotateLeft(Index n)
+		{
+			Index r = nodes_[n].right_;
+			nodes_[n].right_ = nodes_[r].left_;
+			if (nodes_[r].left_ != kNull)
+				nodes_[nodes_[r].left_].parent_ = n;
+			nodes_[r].parent_ = nodes_[n].parent_;
+			ReplaceChild(nodes_[n].parent_, n, r);
+			nodes_[r].left_ = n;
+			nodes_[n].parent_ = r;
+			return r;
+		}
+
+		Index RotateRight(Index n)
+		{
+			Index l = nodes_[n].left_;
+			nodes_[n].left_ = nodes_[l].right_;
+			if (nodes_[l].right_ != kNull)
+				nodes_[nodes_[l].right_].parent_ = n;
+			nodes_[l].parent_ = nodes_[n].parent_;
+			ReplaceChild(nodes_[n].parent_, n, l);
+			nodes_[l].right_ = n;
+			nodes_[n].parent_ = l;
+			return l;
+		}
+
+		// Same as BST::InternalDelete
+		Index InternalDelete(Index n)
+		{
+			Node &node = nodes_[n];
+			Index lowest;
+			if (node.left_ != kNull && node.right_ != kNull)
+			{
+				Index min = node.successor_;
+				Index min_parent = nodes_[min].parent_;
+				if (min_parent != n)
+				{
+					lowest = min_parent;
+					ReplaceChild(min_parent, min, nodes_[min].right_);
+					if (nodes_[min].right_ != kNull)
+						nodes_[nodes_[min].right_].parent_ = min_parent;
+					nodes_[min].right_ = node.right_;
+					nodes_[node.right_].parent_ = min;
+				}
+				else
+					lowest = min;
+				nodes_[min].left_ = node.left_;
+				nodes_[node.left_].parent_ = min;
+				nodes_[min].parent_ = node.parent_;
+				ReplaceChild(node.parent_, n, min);
+				static_cast<NodeData &>(nodes_[min]) = static_cast<const NodeData &>(node);
+			}
+			else
+			{
+				Index child = node.left_ != kNull ? node.left_ : node.right_;
+				if (child != kNull)
+					nodes_[child].parent_ = node.parent_;
+				ReplaceChild(node.parent_, n, child);
+				lowest = node.parent_;
+			}
+
+			if (node.predecessor_ != kNull)
+				nodes_[node.predecessor_].successor_ = node.successor_;
+			if (node.successor_ != kNull)
+				nodes_[node.successor_].predecessor_ = node.predecessor_;
+			return lowest;
+		}
+
+	public:
+		// Reserves room for 'capacity' nodes, so that indices can be turned into stable pointers until then
+		void Reserve(size_t capacity)	{ nodes_.reserve(capacity + 1); }
+
+		// Returns the index of the new node
+		Index Insert(const Element &e)
+		{
+			Index parent = kNull;
+			Index *link = &root_;
+			while (*link != kNull)
+			{
+				parent = *link;
+				if (e < nodes_[parent].data_)
+					link = &nodes_[parent].left_;
+				else
+					link = &nodes_[parent].right_;
+			}
+			bool is_left = (parent != kNull && link == &nodes_[parent].left_);
+			// NewNode may reallocate nodes_, link is not used anymore
+			Index n = NewNode(e, parent);
+			Node &node = nodes_[n];
+			if (parent == kNull)
+				root_ = n;
+			else if (is_left)
+			{
+				Node &p = nodes_[parent];
+				p.left_ = n;
+				node.predecessor_ = p.predecessor_;
+				node.successor_ = parent;
+				if (p.predecessor_ != kNull)
+					nodes_[p.predecessor_].successor_ = n;
+				p.predecessor_ = n;
+			}
+			else
+			{
+				Node &p = nodes_[parent];
+				p.right_ = n;
+				node.predecessor_ = parent;
+				node.successor_ = p.successor_;
+				if (p.successor_ != kNull)
+					nodes_[p.successor_].predecessor_ = n;
+				p.successor_ = n;
+			}
+			if (node.predecessor_ == kNull)
+				min_ = n;
+			if (node.successor_ == kNull)
+				max_ = n;
+			++size_;
+			Balancing::AfterInsert(*this, n);
+			return n;
+		}
+
+		// Returns the index of the node whose value is 'e', or kNull
+		Index Find(const Element &e)	const
+		{
+			Index n = root_;
+			while (n != kNull && e != nodes_[n].data_)
+			{
+				if (e < nodes_[n].data_)
+					n = nodes_[n].left_;
+				else
+					n = nodes_[n].right_;
+			}
+			return n;
+		}
+
+		void Delete(Index n)
+		{
+			Index lowest = InternalDelete(n);
+			if (min_ == n)
+				min_ = nodes_[n].successor_;
+			if (max_ == n)
+				max_ = nodes_[n].predecessor_;
+			nodes_[n].successor_ = free_list_;
+			free_list_ = n;
+			--size_;
+			Balancing::AfterDelete(*this, lowest);
+		}
+
+		void Clear()
+		{
+			nodes_.clear();
+			root_ = kNull;
+			min_ = kNull;
+			max_ = kNull;
+			free_list_ = kNull;
+			size_ = 0;
+		}
+
+		// Forward iterator along the successor list
+		class Iterator
+		{
+		private:
+			const CompactBST *tree_;
+			Index node_;
+
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef Element value_type;
+			typedef ptrdiff_t difference_type;
+			typedef const Element *pointer;
+			typedef const Element &reference;
+
+			Iterator(const CompactBST *tree, Index n) : tree_(tree), node_(n)	{}
+
+			inline reference operator*()	const	{ return tree_->data(node_); }
+			inline pointer operator->()	const	{ return &tree_->data(node_); }
+			inline Iterator &operator++()
+			{
+				node_ = tree_->successor(node_);
+				return *this;
+			}
+			inline Iterator operator++(int)
+			{
+				Iterator it = *this;
+				node_ = tree_->successor(node_);
+				return it;
+			}
+			inline bool operator==(const Iterator &other)	const	{ return node_ == other.node_; }
+			inline bool operator!=(const Iterator &other)	const	{ return node_ != other.node_; }
+		};
+
+		inline Iterator begin()	const	{ return Iterator(this, min_); }
+		inline Iterator end()	const	{ return Iterator(this, kNull); }
+
+		inline const Element &data(Index n)	const	{ return nodes_[n].data_; }
+		inline Index left(Index n)	const	{ return nodes_[n].left_; }
+		inline Index right(Index n)	const	{ return nodes_[n].right_; }
+		inline Index parent(Index n)	const	{ return nodes_[n].parent_; }
+		inline Index successor(Index n)	const	{ return nodes_[n].successor_; }
+		inline Index predecessor(Index n)	const	{ return nodes_[n].predecessor_; }
+		inline Index root()	const	{ return root_; }
+		// Returns the min element in constant time
+		inline Index min()	const	{ return min_; }
+		// Returns the max element in constant time
+		inline Index max()	const	{ return max_; }
+		inline size_t Size()	const	{ return size_; }
+		inline bool IsEmpty()	const	{ return size_ == 0; }
+		inline size_t AllocatedBytes()	const	{ return nodes_.capacity() * sizeof(Node); }
+	};
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#ifndef __CONCURRENT_PRIORITY_QUEUE_H__
+#define __CONCURRENT_PRIORITY_QUEUE_H__
+
+// MultiQueue: relaxed concurrent priority queue made of c*p sequential Yui::Heap, each protected by its own try-lock.
+// - Push inserts into a random queue whose lock is free.
+// - TryPop picks two random non-empty queues and pops from the one whose top is smaller ("power of two choices").
+// Threads rarely contend on the same lock, and the popped element is close to the global minimum with high probability
+// (its expected rank is O(c*p)), which is enough for schedulers and best-first searches that tolerate relaxed order.
+#include "Heap.h"
+#include "ThreadLocalRandom.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+#define __MULTI_QUEUE_CACHE_LINE_SIZE	64
+
+namespace Yui
+{
+	template<typename T, typename Comparator = std::less<T>, unsigned int Arity = 4>
+	class MultiQueue
+	{
+	private:
+		// Each queue lives on its own cache lines so that locking one does not invalidate its neighbours: the queues are
+		// placed in a single block aligned on a cache line, at a stride rounded up to a multiple of the cache line size.
+		// (alignas is not available in VS2013, and new does not honour over-aligned types before C++17 anyway.)
+		struct Queue
+		{
+			std::atomic<bool> locked_;
+			// Read without the lock to skip empty queues
+			std::atomic<size_t> size_;
+			Heap<T, Comparator, Arity> heap_;
+
+			explicit Queue(const Comparator &comparator) : locked_(false), size_(0), heap_(comparator)	{}
+
+			inline bool TryLock()	{ return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire); }
+			inline void Unlock()
+			{
+				size_.store(heap_.Size(), std::memory_order_relaxed);
+				locked_.store(false, std::memory_order_release);
+			}
+		};
+
+		static const size_t kQueueStride = (sizeof(Queue) + __MULTI_QUEUE_CACHE_LINE_SIZE - 1) / __MULTI_QUEUE_CACHE_LINE_SIZE
+			* __MULTI_QUEUE_CACHE_LINE_SIZE;
+
+		std::vector<Queue *> queues_;
+		// Unaligned block holding the queues
+		char *memory_;
+		Comparator comparator_;
+
+		// The high bits of the per-thread generator, the low bits of xorshift being the weakest
+		static inline size_t Random()	{ return size_t(ThreadLocalRandom() >> 16); }
+
+		// Pops the top of the locked queue q and unlocks it
+		inline void PopLocked(Queue *q, T &e)
+		{
+			q->heap_.Pop(e);
+			q->Unlock();
+		}
+
+	public:
+		// 'threads' is the number of threads expected to access the queue and 'queues_per_thread' the factor c: more queues
+		// mean less contention but a more relaxed order.
+		explicit MultiQueue(unsigned int threads, unsigned int queues_per_thread = 2, const Comparator &comparator = Comparator()) :
+			comparator_(comparator)
+		{
+			size_t num_queues = std::max<size_t>(size_t(threads) * queues_per_thread, 2);
+			memory_ = new char[num_queues * kQueueStride + __MULTI_QUEUE_CACHE_LINE_SIZE - 1];
+			uintptr_t aligned = (reinterpret_cast<uintptr_t>(memory_) + __MULTI_QUEUE_CACHE_LINE_SIZE - 1)
+				& ~uintptr_t(__MULTI_QUEUE_CACHE_LINE_SIZE - 1);
+			for (size_t i = 0; i < num_queues; ++i)
+				queues_.push_back(new (reinterpret_cast<char *>(aligned) + i * kQueueStride) Queue(comparator));
+		}
+
+		~MultiQueue()
+		{
+			for (size_t i = 0; i < queues_.size(); ++i)
+				queues_[i]->~Queue();
+			delete[] memory_;
+		}
+
+		MultiQueue(const MultiQueue &) = delete;
+		MultiQueue &operator=(const MultiQueue &) = delete;
+
+		void Push(const T &e)
+		{
+			Queue *q;
+			do
+				q = queues_[Random() % queues_.size()];
+			while (!q->TryLock());
+			q->heap_.Push(e);
+			q->Unlock();
+		}
+
+		void Push(T &&e)
+		{
+			Queue *q;
+			do
+				q = queues_[Random() % queues_.size()];
+			while (!q->TryLock());
+			q->heap_.Push(std::move(e));
+			q->Unlock();
+		}
+
+		// Moves an element close to the minimum into e. Returns false if all the queues were found empty.
+		bool TryPop(T &e)
+		{
+			size_t num_queues = queues_.size();
+			for (int attempt = 0; attempt < 4; ++attempt)
+			{
+				Queue *a = queues_[Random() % num_queues];
+				Queue *b = queues_[Random() % num_queues];
+				if (a->size_.load(std::memory_order_relaxed) == 0)
+					std::swap(a, b);
+				if (a->size_.load(std::memory_order_relaxed) == 0)
+					continue;
+				if (!a->TryLock())
+					continue;
+				if (a->heap_.IsEmpty())
+				{
+					a->Unlock();
+					continue;
+				}
+				// The second queue is only compared when its lock is free, otherwise a alone is used
+				if (a != b && b->size_.load(std::memory_order_relaxed) != 0 && b->TryLock())
+				{
+					if (!b->heap_.IsEmpty() && comparator_(b->heap_.Top(), a->heap_.Top()))
+						std::swap(a, b);
+					b->Unlock();
+				}
+				PopLocked(a, e);
+				return true;
+			}
+
+			// Random probing failed: sweep all the queues from a random start, waiting on locked non-empty queues
+			size_t start = Random() % num_queues;
+			for (size_t i = 0; i < num_queues; ++i)
+			{
+				Queue *q = queues_[(start + i) % num_queues];
+				while (q->size_.load(std::memory_order_relaxed) != 0)
+				{
+					if (!q->TryLock())
+						continue;
+					if (!q->heap_.IsEmpty())
+					{
+						PopLocked(q, e);
+						return true;
+					}
+					q->Unlock();
+				}
+			}
+			return false;
+		}
+
+		// Number of elements, exact only when no other thread is modifying the queue
+		size_t Size()	const
+		{
+			size_t size = 0;
+			for (size_t i = 0; i < queues_.size(); ++i)
+				size += queues_[i]->size_.load(std::memory_order_relaxed);
+			return size;
+		}
+
+		inline bool IsEmpty()	const	{ return Size() == 0; }
+	};
+};
+
+#endif
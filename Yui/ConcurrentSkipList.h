@@ -0,0 +1,330 @@
+#ifndef __CONCURRENT_SKIP_LIST_H__
+#define __CONCURRENT_SKIP_LIST_H__
+
+// Lock-free ordered set implemented as a skip list (see Herlihy and Shavit, The Art of Multiprocessor Programming, and
+// Fraser, Practical lock-freedom). Every node is linked in the sorted list of level 0 and in the lists of the levels above
+// with probability 1/2 per level, so that Insert, Erase and Contains cost O(log n) expected time without any lock.
+// - The links are atomic words whose lowest bit marks the node holding them as deleted. Erase marks the links of a node from
+//   its top level down to level 0, the mark of level 0 being the linearization point, then the node is unlinked by the
+//   searches that cross it. Insert links a node at level 0 first (its linearization point), then at the levels above.
+// - Contains and the traversals never write and never retry, so readers are wait-free.
+// - Erased nodes are not freed while other threads may still read them: they are kept in a retired list and released by
+//   Collect(), to be called when no other thread accesses the list, or by the destructor.
+// As for BST, the successor of an element is reached in constant time (the next node of level 0). The nodes have no back
+// links, which would need a second CAS per level on every update, so the predecessor is found by a search from the head in
+// O(log n) expected time.
+#include "ThreadLocalRandom.h"
+
+#include <atomic>
+#include <functional>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+#define __SKIP_LIST_MAX_LEVEL	32
+
+namespace Yui
+{
+	template<typename Element, typename Comparator = std::less<Element>>
+	class ConcurrentSkipList
+	{
+	public:
+		class Node
+		{
+			friend class ConcurrentSkipList;
+
+		private:
+			Element data_;
+			Node *next_retired_ = nullptr;
+			int height_;
+			// Links to the next node of each level, with the mark bit. Allocated past the end of the node for height_ levels.
+			std::atomic<uintptr_t> next_[1];
+
+			Node(const Element &e, int height) : data_(e), height_(height)	{}
+			Node(int height) : data_(), height_(height)	{}
+
+		public:
+			inline const Element &data()	const	{ return data_; }
+		};
+
+	private:
+		Node *head_;
+		std::atomic<Node *> retired_;
+		std::atomic<size_t> size_;
+		Comparator comparator_;
+
+		static inline Node *Pointer(uintptr_t link)	{ return reinterpret_cast<Node *>(link & ~uintptr_t(1)); }
+		static inline bool IsMarked(uintptr_t link)	{ return (link & 1) != 0; }
+		static inline uintptr_t Link(Node *n)	{ return reinterpret_cast<uintptr_t>(n); }
+
+		static Node *NewNode(int height, const Element *e)
+		{
+			void *memory = ::operator new(sizeof(Node) + (height - 1) * sizeof(std::atomic<uintptr_t>));
+			Node *n = (e ? ::new(memory) Node(*e, height) : ::new(memory) Node(height));
+			for (int level = 1; level < height; ++level)
+				::new(&n->next_[level]) std::atomic<uintptr_t>();
+			for (int level = 0; level < height; ++level)
+				n->next_[level].store(0, std::memory_order_relaxed);
+			return n;
+		}
+
+		static void DeleteNode(Node *n)
+		{
+			n->~Node();
+			::operator delete(n);
+		}
+
+		// The height of a node is 1 plus the number of trailing one bits of a number of the per-thread generator
+		static int RandomHeight()
+		{
+			unsigned long long bits = ThreadLocalRandom();
+			int height = 1;
+			while ((bits & 1) && height < __SKIP_LIST_MAX_LEVEL)
+			{
+				++height;
+				bits >>= 1;
+			}
+			return height;
+		}
+
+		// Fills predecessors and successors with the nodes between which e belongs at each level, and unlinks the marked
+		// nodes met on the way. Restarts from the head if a predecessor was concurrently modified. Returns true if
+		// successors[0] holds an element equal to e.
+		bool Search(const Element &e, Node **predecessors, Node **successors)
+		{
+		retry:
+			Node *predecessor = head_;
+			for (int level = __SKIP_LIST_MAX_LEVEL - 1; level >= 0; --level)
+			{
+				Node *current = Pointer(predecessor->next_[level].load());
+				while (current)
+				{
+					uintptr_t next = current->next_[level].load();
+					// Unlink the deleted nodes that follow predecessor
+					while (IsMarked(next))
+					{
+						uintptr_t expected = Link(current);
+						if (!predecessor->next_[level].compare_exchange_strong(expected, next & ~uintptr_t(1)))
+							goto retry;
+						current = Pointer(next);
+						if (!current)
+							break;
+						next = current->next_[level].load();
+					}
+					if (!current || !comparator_(current->data_, e))
+						break;
+					predecessor = current;
+					current = Pointer(next);
+				}
+				predecessors[level] = predecessor;
+				successors[level] = current;
+			}
+			return successors[0] && !comparator_(e, successors[0]->data_);
+		}
+
+		void Retire(Node *n)
+		{
+			Node *head = retired_.load();
+			do
+				n->next_retired_ = head;
+			while (!retired_.compare_exchange_weak(head, n));
+		}
+
+	public:
+		explicit ConcurrentSkipList(const Comparator &comparator = Comparator()) :
+			head_(NewNode(__SKIP_LIST_MAX_LEVEL, nullptr)), retired_(nullptr), size_(0), comparator_(comparator)	{}
+
+		~ConcurrentSkipList()
+		{
+			Collect();
+			Node *n = head_;
+			while (n)
+			{
+				Node *next = Pointer(n->next_[0].load());
+				DeleteNode(n);
+				n = next;
+			}
+		}
+
+		ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+		ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+		// Inserts e if no equal element is in the list. Returns false otherwise. Lock-free, O(log n) expected.
+		bool Insert(const Element &e)
+		{
+			Node *predecessors[__SKIP_LIST_MAX_LEVEL];
+			Node *successors[__SKIP_LIST_MAX_LEVEL];
+			int height = RandomHeight();
+			Node *n = nullptr;
+			while (true)
+			{
+				if (Search(e, predecessors, successors))
+				{
+					if (n)
+						DeleteNode(n);
+					return false;
+				}
+				if (!n)
+					n = NewNode(height, &e);
+				for (int level = 0; level < height; ++level)
+					n->next_[level].store(Link(successors[level]), std::memory_order_relaxed);
+				uintptr_t expected = Link(successors[0]);
+				if (predecessors[0]->next_[0].compare_exchange_strong(expected, Link(n)))
+					break;
+			}
+			++size_;
+
+			// Link the levels above. The node may be erased meanwhile, in which case its links are marked and linking stops.
+			for (int level = 1; level < height; ++level)
+			{
+				while (true)
+				{
+					uintptr_t next = n->next_[level].load();
+					if (IsMarked(next))
+						return true;
+					if (Pointer(next) != successors[level] && !n->next_[level].compare_exchange_strong(next, Link(successors[level])))
+						continue;
+					uintptr_t expected = Link(successors[level]);
+					if (predecessors[level]->next_[level].compare_exchange_strong(expected, Link(n)))
+					{
+						// Erased before being linked at this level: the eraser's search may have missed it, unlink it again
+						if (IsMarked(n->next_[level].load()))
+						{
+							Search(e, predecessors, successors);
+							return true;
+						}
+						break;
+					}
+					if (!Search(e, predecessors, successors) || successors[0] != n)
+						return true;
+				}
+			}
+			return true;
+		}
+
+		// Erases the element equal to e. Returns false if there is none. Lock-free, O(log n) expected.
+		bool Erase(const Element &e)
+		{
+			Node *predecessors[__SKIP_LIST_MAX_LEVEL];
+			Node *successors[__SKIP_LIST_MAX_LEVEL];
+			if (!Search(e, predecessors, successors))
+				return false;
+			Node *victim = successors[0];
+			for (int level = victim->height_ - 1; level > 0; --level)
+			{
+				uintptr_t next = victim->next_[level].load();
+				while (!IsMarked(next) && !victim->next_[level].compare_exchange_weak(next, next | 1))
+					;
+			}
+			uintptr_t next = victim->next_[0].load();
+			while (true)
+			{
+				// Another thread erased the element first
+				if (IsMarked(next))
+					return false;
+				if (victim->next_[0].compare_exchange_strong(next, next | 1))
+					break;
+			}
+			--size_;
+			// Unlink the node at every level
+			Search(e, predecessors, successors);
+			Retire(victim);
+			return true;
+		}
+
+		// Returns true if an element equal to e is in the list. Wait-free, O(log n) expected.
+		bool Contains(const Element &e)	const
+		{
+			const Node *n = LowerBound(e);
+			return n && !comparator_(e, n->data_);
+		}
+
+		// Returns the node of the first element larger than or equal to e that is not erased, or nullptr. Wait-free.
+		const Node *LowerBound(const Element &e)	const
+		{
+			const Node *predecessor = head_;
+			const Node *current = nullptr;
+			for (int level = __SKIP_LIST_MAX_LEVEL - 1; level >= 0; --level)
+			{
+				current = Pointer(predecessor->next_[level].load());
+				while (current)
+				{
+					uintptr_t next = current->next_[level].load();
+					// Skip the erased nodes without unlinking them
+					if (!IsMarked(next) && !comparator_(current->data_, e))
+						break;
+					if (!IsMarked(next))
+						predecessor = current;
+					current = Pointer(next);
+				}
+			}
+			return current;
+		}
+
+		// Returns the node following n in increasing order that is not erased, or nullptr. Constant time when no erased node
+		// is met.
+		const Node *Next(const Node *n)	const
+		{
+			const Node *next = Pointer(n->next_[0].load());
+			while (next && IsMarked(next->next_[0].load()))
+				next = Pointer(next->next_[0].load());
+			return next;
+		}
+
+		// Returns the node of the last element smaller than e that is not erased, or nullptr. Wait-free, O(log n) expected
+		// like LowerBound since the nodes are only linked forward.
+		const Node *Predecessor(const Element &e)	const
+		{
+			const Node *predecessor = head_;
+			for (int level = __SKIP_LIST_MAX_LEVEL - 1; level >= 0; --level)
+			{
+				const Node *current = Pointer(predecessor->next_[level].load());
+				while (current)
+				{
+					uintptr_t next = current->next_[level].load();
+					// Skip the erased nodes without unlinking them
+					if (!IsMarked(next))
+					{
+						if (!comparator_(current->data_, e))
+							break;
+						predecessor = current;
+					}
+					current = Pointer(next);
+				}
+			}
+			return predecessor == head_ ? nullptr : predecessor;
+		}
+
+		// Returns the node preceding n in increasing order that is not erased, or nullptr. O(log n) expected, contrary to Next.
+		inline const Node *Prev(const Node *n)	const	{ return Predecessor(n->data_); }
+
+		inline const Node *First()	const	{ return Next(head_); }
+
+		// Calls fn(e) for each element e such that lo <= e <= hi in increasing order. The walk is weakly consistent: it sees
+		// the elements that were in the list for the whole walk, and may or may not see the concurrent updates.
+		template<typename F>
+		void ForEachInRange(const Element &lo, const Element &hi, F fn)	const
+		{
+			for (const Node *n = LowerBound(lo); n && !comparator_(hi, n->data_); n = Next(n))
+				fn(n->data_);
+		}
+
+		// Frees the erased nodes. Must be called while no other thread accesses the list.
+		void Collect()
+		{
+			Node *n = retired_.exchange(nullptr);
+			while (n)
+			{
+				Node *next = n->next_retired_;
+				DeleteNode(n);
+				n = next;
+			}
+		}
+
+		// Number of elements, exact only when no other thread is modifying the list
+		inline size_t Size()	const	{ return size_.load(); }
+		inline bool IsEmpty()	const	{ return Size() == 0; }
+	};
+};
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef __EXTERNAL_SORT_H__
+#define __EXTERNAL_SORT_H__
+
+// External merge sort of binary files of fixed-size records, for datasets that do not fit in memory.
+// 1. Run generation: the input is read in chunks of at most memory_budget/2 bytes, each chunk is sorted with Yui::MergeSort
+//    (which allocates a merge buffer of the size of the chunk) and written to a temporary run file next to the output file.
+// 2. K-way merge: the runs are merged with a Yui::Heap holding the smallest unmerged record of each run. The memory budget
+//    is split between one read buffer per run and the output buffer, so that all the I/O is done with large sequential
+//    reads and writes. The number of runs merged at once is capped so that each buffer keeps at least
+//    __EXTERNAL_SORT_MIN_BUFFER_BYTES bytes and at most __EXTERNAL_SORT_MAX_FAN_IN files are open; when there are more runs,
+//    groups of runs are first merged into intermediate runs, in as many passes as needed.
+#include "Heap.h"
+#include "Sort.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <type_traits>
+
+#ifndef __EXTERNAL_SORT_MIN_BUFFER_BYTES
+// Minimum size of the read and write buffers of a merge, unless the memory budget cannot hold 3 of them
+#define __EXTERNAL_SORT_MIN_BUFFER_BYTES	(1 << 20)
+#endif
+
+#ifndef __EXTERNAL_SORT_MAX_FAN_IN
+// Maximum number of runs merged at once, under the limit of open files of the C runtimes (512 streams for MSVC)
+#define __EXTERNAL_SORT_MAX_FAN_IN	256
+#endif
+
+namespace Yui
+{
+	struct ExternalSortStatistics
+	{
+		unsigned long long bytes_read_ = 0;
+		unsigned long long bytes_written_ = 0;
+		size_t num_records_ = 0;
+		size_t num_runs_ = 0;
+		// Number of merge passes, and bytes written to the intermediate runs of the passes before the last one (each of
+		// them is read once more, so the extra I/O is twice this amount)
+		size_t num_merge_passes_ = 0;
+		unsigned long long intermediate_bytes_written_ = 0;
+	};
+
+	// Reads the records of a file by blocks of buffer_size records
+	template<typename T>
+	class ExternalSortReader
+	{
+	private:
+		std::ifstream file_;
+		std::vector<T> buffer_;
+		size_t buffer_size_ = 0;
+		size_t position_ = 0;
+		ExternalSortStatistics *statistics_;
+
+		void Fill()
+		{
+			file_.read(reinterpret_cast<char *>(&buffer_[0]), buffer_.size() * sizeof(T));
+			buffer_size_ = size_t(file_.gcount()) / sizeof(T);
+			position_ = 0;
+			statistics_->bytes_read_ += buffer_size_ * sizeof(T);
+		}
+
+	public:
+		ExternalSortReader(const std::string &path, size_t buffer_size, ExternalSortStatistics *statistics) :
+			file_(path, std::ios::in | std::ios::binary), buffer_(buffer_size > 0 ? buffer_size : 1), statistics_(statistics)
+		{
+			if (file_)
+				Fill();
+		}
+
+		inline bool IsOpen()	const	{ return file_.is_open(); }
+		// False after a read error. Reaching the end of the file is not an error.
+		inline bool IsGood()	const	{ return !file_.bad(); }
+		inline bool IsEmpty()	const	{ return position_ == buffer_size_; }
+		inline T &Front()	{ return buffer_[position_]; }
+
+		void Next()
+		{
+			if (++position_ == buffer_size_ && file_)
+				Fill();
+		}
+	};
+
+	// Writes records to a file by blocks of buffer_size records
+	template<typename T>
+	class ExternalSortWriter
+	{
+	private:
+		std::ofstream file_;
+		std::vector<T> buffer_;
+		size_t buffer_size_ = 0;
+		ExternalSortStatistics *statistics_;
+
+	public:
+		ExternalSortWriter(const std::string &path, size_t buffer_size, ExternalSortStatistics *statistics) :
+			file_(path, std::ios::out | std::ios::binary | std::ios::trunc), buffer_(buffer_size > 0 ? buffer_size : 1), statistics_(statistics)	{}
+		~ExternalSortWriter()	{ Flush(); }
+
+		inline bool IsOpen()	const	{ return file_.is_open(); }
+		// False once a write failed (disk full, I/O error): the file is then truncated
+		inline bool IsGood()	const	{ return !file_.fail(); }
+
+		inline void Write(const T &record)
+		{
+			buffer_[buffer_size_++] = record;
+			if (buffer_size_ == buffer_.size())
+				Flush();
+		}
+
+		// Writes 'count' records at once, bypassing the buffer. Returns false if the file could not be written.
+		bool Write(const T *records, size_t count)
+		{
+			if (!Flush())
+				return false;
+			file_.write(reinterpret_cast<const char *>(records), count * sizeof(T));
+			if (!file_)
+				return false;
+			statistics_->bytes_written_ += count * sizeof(T);
+			return true;
+		}
+
+		// Writes the buffered records and flushes the stream. Returns false if the file could not be written.
+		bool Flush()
+		{
+			if (buffer_size_ > 0)
+			{
+				file_.write(reinterpret_cast<const char *>(&buffer_[0]), buffer_size_ * sizeof(T));
+				if (file_)
+					statistics_->bytes_written_ += buffer_size_ * sizeof(T);
+				buffer_size_ = 0;
+			}
+			file_.flush();
+			return IsGood();
+		}
+	};
+
+	template<typename T>
+	struct ExternalSortHeapItem
+	{
+		T record_;
+		size_t run_;
+	};
+
+	template<typename T, typename Comparator>
+	struct ExternalSortHeapItemComparator
+	{
+		Comparator comparator_;
+		ExternalSortHeapItemComparator()	{}
+		explicit ExternalSortHeapItemComparator(const Comparator &comparator) : comparator_(comparator)	{}
+		inline bool operator()(ExternalSortHeapItem<T> &a, ExternalSortHeapItem<T> &b)	{ return comparator_(a.record_, b.record_); }
+	};
+
+	// Merges the sorted runs run_paths[begin..end) into 'output_path' with buffers sharing budget_size records. Returns false
+	// if a file could not be opened, read or written.
+	template<typename T, typename Comparator>
+	bool ExternalSortMerge(const std::vector<std::string> &run_paths, size_t begin, size_t end, const std::string &output_path,
+		size_t budget_size, Comparator comparator, ExternalSortStatistics *statistics)
+	{
+		bool success = true;
+		size_t buffer_size = std::max<size_t>(budget_size / (end - begin + 1), 1);
+		std::vector<ExternalSortReader<T> *> readers;
+		Heap<ExternalSortHeapItem<T>, ExternalSortHeapItemComparator<T, Comparator>> heap((ExternalSortHeapItemComparator<T, Comparator>(comparator)));
+		for (size_t run = begin; run < end; ++run)
+		{
+			readers.push_back(new ExternalSortReader<T>(run_paths[run], buffer_size, statistics));
+			if (!readers.back()->IsOpen())
+				success = false;
+			else if (!readers.back()->IsEmpty())
+			{
+				ExternalSortHeapItem<T> item = { readers.back()->Front(), run - begin };
+				heap.Push(item);
+				readers.back()->Next();
+			}
+		}
+		ExternalSortWriter<T> writer(output_path, buffer_size, statistics);
+		if (!writer.IsOpen())
+			success = false;
+		while (success && !heap.IsEmpty())
+		{
+			ExternalSortHeapItem<T> item;
+			heap.Pop(item);
+			writer.Write(item.record_);
+			ExternalSortReader<T> *reader = readers[item.run_];
+			if (!reader->IsEmpty())
+			{
+				item.record_ = reader->Front();
+				heap.Push(item);
+				reader->Next();
+			}
+			success = writer.IsGood() && reader->IsGood();
+		}
+		if (success)
+			success = writer.Flush();
+		for (size_t run = 0; run < readers.size(); ++run)
+			delete readers[run];
+		return success;
+	}
+
+	// Sorts the records of type T stored in the binary file 'input_path' and writes them to 'output_path', using at most about
+	// memory_budget bytes of memory: runs of memory_budget/2 bytes plus the merge buffer of Yui::MergeSort while sorting them,
+	// then read and write buffers sharing memory_budget bytes while merging them. T must be trivially copyable. 'threads' is
+	// passed to Yui::MergeSort to sort the runs.
+	// When there are more runs than can be merged at once (see __EXTERNAL_SORT_MIN_BUFFER_BYTES and __EXTERNAL_SORT_MAX_FAN_IN),
+	// each pass but the last merges consecutive groups of runs into intermediate runs, and removes the runs it merged.
+	// Returns false if a file could not be opened, read or written, or if the size of the input is not a multiple of sizeof(T).
+	// The temporary run files are only removed on success, so that no sorted data is lost when the output could not be
+	// written. When 'statistics' is not null, it receives the number of bytes read and written (temporary runs included) and
+	// the number of runs.
+	template<typename T, typename Comparator>
+	bool ExternalSort(const std::string &input_path, const std::string &output_path, size_t memory_budget, Comparator comparator,
+		unsigned int threads, ExternalSortStatistics *statistics = nullptr)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Yui::ExternalSort requires trivially copyable records");
+		ExternalSortStatistics local_statistics;
+		if (!statistics)
+			statistics = &local_statistics;
+		*statistics = ExternalSortStatistics();
+		size_t budget_size = std::max<size_t>(memory_budget / sizeof(T), 1);
+		size_t run_size = std::max<size_t>(budget_size / 2, 1);
+
+		// Run generation. The input is read without an intermediate buffer since the run itself is the buffer.
+		std::vector<std::string> run_paths;
+		{
+			std::ifstream input(input_path, std::ios::in | std::ios::binary);
+			if (!input)
+				return false;
+			std::vector<T> run(run_size);
+			while (true)
+			{
+				input.read(reinterpret_cast<char *>(&run[0]), run_size * sizeof(T));
+				size_t num_bytes = size_t(input.gcount());
+				// Trailing partial record, or read error
+				if (num_bytes % sizeof(T) != 0 || input.bad())
+					return false;
+				size_t num_records = num_bytes / sizeof(T);
+				if (num_records == 0)
+					break;
+				statistics->bytes_read_ += num_records * sizeof(T);
+				statistics->num_records_ += num_records;
+				MergeSort(run.begin(), run.begin() + num_records, comparator, threads);
+
+				// A single run is directly written to the output
+				bool single_run = run_paths.empty() && num_records < run_size;
+				run_paths.push_back(single_run ? output_path : output_path + ".run" + std::to_string(run_paths.size()));
+				ExternalSortWriter<T> writer(run_paths.back(), 1, statistics);
+				if (!writer.IsOpen() || !writer.Write(&run[0], num_records) || !writer.Flush())
+					return false;
+				if (single_run)
+					break;
+			}
+		}
+		statistics->num_runs_ = run_paths.size();
+		if (run_paths.empty())
+		{
+			ExternalSortWriter<T> writer(output_path, 1, statistics);
+			return writer.IsOpen() && writer.Flush();
+		}
+		if (run_paths.size() == 1 && run_paths[0] == output_path)
+			return true;
+
+		// K-way merge. The fan-in leaves each of the fan_in+1 buffers at least __EXTERNAL_SORT_MIN_BUFFER_BYTES bytes, but is at
+		// least 2 so that the passes always reduce the number of runs.
+		size_t min_buffer_size = std::max<size_t>(__EXTERNAL_SORT_MIN_BUFFER_BYTES / sizeof(T), 1);
+		size_t fan_in = std::max<size_t>(std::min<size_t>(budget_size / min_buffer_size, __EXTERNAL_SORT_MAX_FAN_IN + 1), 3) - 1;
+		size_t next_run = run_paths.size();
+		while (run_paths.size() > fan_in)
+		{
+			// A group of a single run is carried over to the next pass as is
+			std::vector<std::string> merged_paths;
+			unsigned long long bytes_written = statistics->bytes_written_;
+			for (size_t begin = 0; begin < run_paths.size(); begin += fan_in)
+			{
+				size_t end = std::min(begin + fan_in, run_paths.size());
+				if (end - begin == 1)
+				{
+					merged_paths.push_back(run_paths[begin]);
+					continue;
+				}
+				merged_paths.push_back(output_path + ".run" + std::to_string(next_run++));
+				if (!ExternalSortMerge<T>(run_paths, begin, end, merged_paths.back(), budget_size, comparator, statistics))
+					return false;
+				for (size_t run = begin; run < end; ++run)
+					remove(run_paths[run].c_str());
+			}
+			statistics->intermediate_bytes_written_ += statistics->bytes_written_ - bytes_written;
+			++statistics->num_merge_passes_;
+			run_paths.swap(merged_paths);
+		}
+		if (!ExternalSortMerge<T>(run_paths, 0, run_paths.size(), output_path, budget_size, comparator, statistics))
+			return false;
+		++statistics->num_merge_passes_;
+		for (size_t run = 0; run < run_paths.size(); ++run)
+			remove(run_paths[run].c_str());
+		return true;
+	}
+
+	// Sorts the records of the binary file 'input_path' in increasing order and writes them to 'output_path'
+	template<typename T>
+	bool ExternalSort(const std::string &input_path, const std::string &output_path, size_t memory_budget, unsigned int threads = 1,
+		ExternalSortStatistics *statistics = nullptr)
+	{
+		return ExternalSort<T>(input_path, output_path, memory_budget, std::less<T>(), threads, statistics);
+	}
+};
+
+#endif
@@ -1,8 +1,13 @@
 #ifndef __HEAP_H__
 #define __HEAP_H__
 
+#include <algorithm>
 #include <functional>
+#include <new>
+#include <utility>
 #include <vector>
+#include <stddef.h>
+#include <string.h>
 
 namespace Yui
 {
@@ -90,106 +95,503 @@ namespace Yui
 		BubbleDown(it_root, it_begin, it_end, comparator);
 	}
 
-	template<typename T, typename Comparator = std::less<T>>
+	// Floyd's bottom-up variant of BubbleDown for a heap whose root is the maximum with regards to comparator:
+	// the hole left at 'hole' is first moved down to a leaf along the path of the largest children, which costs one comparison
+	// per level instead of two, then the displaced element is bubbled up from that leaf, which usually stops after a level or two
+	// since most elements belong near the leaves. num_elements is the size of the heap starting at it_begin.
+	template<typename T, typename Comparator>
+	void BottomUpBubbleDown(T it_begin, size_t hole, size_t num_elements, Comparator &comparator)
+	{
+		auto value = std::move(*(it_begin + hole));
+		size_t start = hole;
+		size_t child = (hole << 1) + 1;
+		while (child + 1 < num_elements)
+		{
+			if (comparator(*(it_begin + child), *(it_begin + child + 1)))
+				++child;
+			*(it_begin + hole) = std::move(*(it_begin + child));
+			hole = child;
+			child = (hole << 1) + 1;
+		}
+		if (child < num_elements)
+		{
+			*(it_begin + hole) = std::move(*(it_begin + child));
+			hole = child;
+		}
+		while (hole > start)
+		{
+			size_t parent = (hole - 1) >> 1;
+			if (!comparator(*(it_begin + parent), value))
+				break;
+			*(it_begin + hole) = std::move(*(it_begin + parent));
+			hole = parent;
+		}
+		*(it_begin + hole) = std::move(value);
+	}
+
+#ifndef __MAKE_HEAP_SUBTREE_SIZE
+	// Yui::MakeHeap builds the subtrees of about __MAKE_HEAP_SUBTREE_SIZE elements one after the other so that they stay in cache
+#define __MAKE_HEAP_SUBTREE_SIZE 32768
+#endif
+
+	// Transforms the range of elements between it_begin and it_end-1 included into a binary heap whose root is the maximum with
+	// regards to comparator, in O(n) time. Instead of bubbling down the nodes level by level over the whole array, the heap is
+	// built by subtrees of about __MAKE_HEAP_SUBTREE_SIZE elements which are independent, hence built in parallel, then the
+	// levels above the subtrees are built.
+	template<typename T, typename Comparator>
+	void MakeHeap(T it_begin, T it_end, Comparator comparator, unsigned int threads = 1)
+	{
+		size_t num_elements = it_end - it_begin;
+		if (num_elements < 2)
+			return;
+		int height = 0;
+		while ((size_t(2) << height) <= num_elements)
+			++height;
+		int subtree_height = 0;
+		while ((size_t(2) << subtree_height) <= __MAKE_HEAP_SUBTREE_SIZE)
+			++subtree_height;
+		// The subtrees are rooted at 'subtree_level'. Make sure there are enough subtrees for all the threads.
+		int subtree_level = height > subtree_height ? height - subtree_height : 0;
+		while (subtree_level < height && (size_t(1) << subtree_level) < 4 * size_t(threads))
+			++subtree_level;
+
+		int num_subtrees = 1 << subtree_level;
+		size_t first_subtree_root = size_t(num_subtrees) - 1;
+		size_t num_parents = num_elements >> 1;
+#pragma omp parallel for schedule(dynamic) num_threads(threads > 0 ? threads : 1) if (threads > 1)
+		for (int subtree = 0; subtree < num_subtrees; ++subtree)
+		{
+			// The nodes of the subtree at relative depth d are the 2^d nodes starting at (root+1)*2^d-1
+			size_t root = first_subtree_root + subtree;
+			for (int depth = height - subtree_level; depth >= 0; --depth)
+			{
+				size_t level_begin = ((root + 1) << depth) - 1;
+				size_t level_end = std::min(level_begin + (size_t(1) << depth), num_parents);
+				for (size_t node = level_end; node-- > level_begin;)
+					BottomUpBubbleDown(it_begin, node, num_elements, comparator);
+			}
+		}
+		for (size_t node = std::min(first_subtree_root, num_parents); node-- > 0;)
+			BottomUpBubbleDown(it_begin, node, num_elements, comparator);
+	}
+
+	// Sorts a heap built by Yui::MakeHeap in increasing order with regards to comparator
+	template<typename T, typename Comparator>
+	void SortHeap(T it_begin, T it_end, Comparator comparator)
+	{
+		for (size_t num_elements = it_end - it_begin; num_elements > 1; --num_elements)
+		{
+			std::swap(*it_begin, *(it_begin + (num_elements - 1)));
+			BottomUpBubbleDown(it_begin, 0, num_elements - 1, comparator);
+		}
+	}
+
+#ifndef __HEAP_CACHE_LINE_SIZE
+#define __HEAP_CACHE_LINE_SIZE 64
+#endif
+
+	// Allocator placing the element of index 1 at the beginning of a cache line. The children of node i of a d-ary heap are
+	// stored at indices d*i+1...d*i+d, hence each group of siblings fills exactly one cache line when d*sizeof(T) is
+	// __HEAP_CACHE_LINE_SIZE, and fetching the children of a node costs a single cache miss.
+	template<typename T>
+	class HeapAllocator
+	{
+	public:
+		typedef T value_type;
+		typedef T *pointer;
+		typedef const T *const_pointer;
+		typedef T &reference;
+		typedef const T &const_reference;
+		typedef size_t size_type;
+		typedef ptrdiff_t difference_type;
+		template<typename U>
+		struct rebind
+		{
+			typedef HeapAllocator<U> other;
+		};
+
+		HeapAllocator()	{}
+		template<typename U>
+		HeapAllocator(const HeapAllocator<U> &)	{}
+
+		T *allocate(size_t n, const void * = nullptr)
+		{
+			// The address of the allocated block is stored right before the returned pointer
+			char *block = static_cast<char *>(::operator new(n * sizeof(T) + sizeof(void *) + __HEAP_CACHE_LINE_SIZE - 1));
+			size_t aligned = (reinterpret_cast<size_t>(block) + sizeof(void *) + sizeof(T) + __HEAP_CACHE_LINE_SIZE - 1) & ~size_t(__HEAP_CACHE_LINE_SIZE - 1);
+			char *p = reinterpret_cast<char *>(aligned) - sizeof(T);
+			memcpy(p - sizeof(void *), &block, sizeof(void *));
+			return reinterpret_cast<T *>(p);
+		}
+
+		void deallocate(T *p, size_t)
+		{
+			char *block;
+			memcpy(&block, reinterpret_cast<char *>(p) - sizeof(void *), sizeof(void *));
+			::operator delete(block);
+		}
+
+		inline T *address(T &e)	const	{ return &e; }
+		inline const T *address(const T &e)	const	{ return &e; }
+		inline size_t max_size()	const	{ return size_t(-1) / sizeof(T); }
+		template<typename U, typename... Args>
+		inline void construct(U *p, Args&&... args)	{ ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...); }
+		template<typename U>
+		inline void destroy(U *p)	{ p->~U(); }
+		template<typename U>
+		inline bool operator==(const HeapAllocator<U> &)	const	{ return true; }
+		template<typename U>
+		inline bool operator!=(const HeapAllocator<U> &)	const	{ return false; }
+	};
+
+	// d-ary heap whose top element is the minimum with regards to Comparator. With Arity 4 or 8, the heap is shallower than a
+	// binary heap and the children of a node share a cache line (see HeapAllocator), at the cost of more comparisons per level.
+	template<typename T, typename Comparator = std::less<T>, unsigned int Arity = 2>
 	class Heap
 	{
+		static_assert(Arity >= 2, "Yui::Heap requires an arity of at least 2");
+
 	private:
-		std::vector<T> data_;
+		std::vector<T, HeapAllocator<T>> data_;
 		Comparator comparator_;
 
-		// Find the minimum among the elements at i, its left and right children in the binary heap structure; then
-		// swap the latter with the element at i. Recursively swap the elements downstream in the binary heap if a swap occured.
+		// Find the minimum among the element at i and its children in the heap structure; then swap the latter with the
+		// element at i. Repeat downstream in the heap if a swap occured.
 		// Non recursive function.
-		void BubbleDown(unsigned int i)
+		void BubbleDown(size_t i)
 		{
-			unsigned int min = i;
-			unsigned int current_index = i;
-			unsigned int right = ((current_index + 1) << 1);
-			unsigned int left = right - 1;
-			// Recursively bubble down the minimum value
+			size_t size = data_.size();
+			if (i >= size)
+				return;
+			T value_to_bubble_down = std::move(data_[i]);
+			size_t current_index = i;
 			while (true)
 			{
+				size_t first_child = current_index * Arity + 1;
+				if (first_child >= size)
+					break;
+				size_t last_child = std::min(first_child + Arity, size);
 				// Find the minimum
-				if (right < data_.size())
-				{
-					if (comparator_(data_[right], data_[min]))
-						min = right;
-				}
-				if (left < data_.size())
+				size_t min = first_child;
+				for (size_t child = first_child + 1; child < last_child; ++child)
 				{
-					if (comparator_(data_[left], data_[min]))
-						min = left;
+					if (comparator_(data_[child], data_[min]))
+						min = child;
 				}
-				if (min != current_index)
-				{
-					T min_value = data_[min];
-					data_[min] = data_[current_index];
-					data_[current_index] = min_value;
-					current_index = min;
-					right = ((current_index + 1) << 1);
-					left = right - 1;
-				}
-				else
+				if (!comparator_(data_[min], value_to_bubble_down))
 					break;
+				data_[current_index] = std::move(data_[min]);
+				current_index = min;
 			}
+			data_[current_index] = std::move(value_to_bubble_down);
 		}
 
-		// Find the minimum among it_child and its parent in the binary heap structure; then
-		// swap the latter with the parent. Recursively swap the elements upstream in the binary heap if a swap occured.
+		// Find the minimum among it_child and its parent in the heap structure; then swap the latter with the parent.
+		// Repeat upstream in the heap if a swap occured.
 		// Non recursive function.
-		void BubbleUp(int i)
+		void BubbleUp(size_t i)
 		{
 			if (i == 0)
 				return;
-			T value_to_bubble_up = data_[i];
-			int child = i;
-			int parent = ((child - 1) >> 2);
-
-			while (child != parent)
+			T value_to_bubble_up = std::move(data_[i]);
+			size_t child = i;
+			while (child > 0)
 			{
-				if (comparator_(value_to_bubble_up, data_[parent]))
+				size_t parent = (child - 1) / Arity;
+				if (!comparator_(value_to_bubble_up, data_[parent]))
 				{
-					data_[child] = data_[parent];
-					child = parent;
-					if (child > 0)
-						parent = ((child - 1) >> 2);
+					// We found the final position of value_to_bubble_up in the heap
+					break;
 				}
-				else
-				{
-					// We found the final position of value_to_bubble_up in the heap	
+				data_[child] = std::move(data_[parent]);
+				child = parent;
+			}
+			data_[child] = std::move(value_to_bubble_up);
+		}
+
+		// Bubbles down every parent node, from the last one to the root, in O(n) time
+		void Heapify()
+		{
+			if (data_.size() < 2)
+				return;
+			for (size_t i = (data_.size() - 2) / Arity + 1; i-- > 0;)
+				BubbleDown(i);
+		}
+
+		// Removes the root, whose value must have been moved out. The hole left at the root is moved down to a leaf along the
+		// path of the minimum children, then the last element fills it and is bubbled up, which saves a comparison per level
+		// compared to bubbling down the last element from the root (see BottomUpBubbleDown).
+		void RemoveTop()
+		{
+			size_t size = data_.size() - 1;
+			size_t hole = 0;
+			while (true)
+			{
+				size_t first_child = hole * Arity + 1;
+				if (first_child >= size)
 					break;
+				size_t last_child = std::min(first_child + Arity, size);
+				size_t min = first_child;
+				for (size_t child = first_child + 1; child < last_child; ++child)
+				{
+					if (comparator_(data_[child], data_[min]))
+						min = child;
 				}
+				data_[hole] = std::move(data_[min]);
+				hole = min;
+			}
+			if (hole != size)
+			{
+				data_[hole] = std::move(data_[size]);
+				data_.pop_back();
+				BubbleUp(hole);
 			}
-			data_[child] = value_to_bubble_up;
+			else
+				data_.pop_back();
 		}
 
 	public:
 		Heap()	{}
+		explicit Heap(const Comparator &comparator) : comparator_(comparator)	{}
+
+		// Builds a heap from the elements between it_begin and it_end-1 inclusive in O(n) time
+		template<typename U>
+		Heap(U it_begin, U it_end, const Comparator &comparator = Comparator()) : data_(it_begin, it_end), comparator_(comparator)
+		{
+			Heapify();
+		}
+
 		void Push(const T &e)
 		{
 			data_.push_back(e);
 			BubbleUp(data_.size() - 1);
 		}
 
-		void Push(const T &&e)
+		void Push(T &&e)
 		{
 			data_.push_back(std::move(e));
 			BubbleUp(data_.size() - 1);
 		}
 
+		// Inserts the elements between it_begin and it_end-1 inclusive. When the batch is large with regards to the heap, the
+		// elements are appended and the whole heap is rebuilt in O(n+m) time instead of bubbling up each of them in O(m*log(n+m)).
+		template<typename U>
+		void PushBatch(U it_begin, U it_end)
+		{
+			size_t old_size = data_.size();
+			data_.insert(data_.end(), it_begin, it_end);
+			size_t size = data_.size();
+			size_t log_size = 0;
+			while ((size_t(1) << log_size) < size)
+				++log_size;
+			if ((size - old_size) * log_size > size)
+				Heapify();
+			else
+			{
+				for (size_t i = old_size; i < size; ++i)
+					BubbleUp(i);
+			}
+		}
+
+		void Pop(T &e)
+		{
+			e = std::move(data_[0]);
+			RemoveTop();
+		}
+
+		// Moves the min(k, Size()) smallest elements to it_output in increasing order and removes them from the heap.
+		// Returns the iterator past the last element written.
+		template<typename U>
+		U PopBatch(size_t k, U it_output)
+		{
+			for (; k > 0 && !data_.empty(); --k)
+			{
+				*it_output = std::move(data_[0]);
+				++it_output;
+				RemoveTop();
+			}
+			return it_output;
+		}
+
+		// Returns the minimum element in constant time
+		inline const T &Top()	const	{ return data_[0]; }
+		inline size_t Size()	const	{ return data_.size(); }
+		inline bool IsEmpty()	const	{ return data_.empty(); }
+	};
+
+	// d-ary heap whose elements can be updated or removed after insertion through the handle returned by Push, in O(log n).
+	// Each entry of the heap stores the element next to its handle so that comparisons never leave the heap array, and
+	// positions_ maps each handle to the index of its entry. Handles of popped or erased elements are recycled.
+	template<typename T, typename Comparator = std::less<T>, unsigned int Arity = 4>
+	class IndexedHeap
+	{
+		static_assert(Arity >= 2, "Yui::IndexedHeap requires an arity of at least 2");
+
+	public:
+		typedef size_t Handle;
+		static const size_t kInvalidPosition = size_t(-1);
+
+	private:
+		struct Entry
+		{
+			T value_;
+			Handle handle_;
+			Entry(const T &value, Handle handle) : value_(value), handle_(handle)	{}
+			Entry(T &&value, Handle handle) : value_(std::move(value)), handle_(handle)	{}
+		};
+
+		std::vector<Entry, HeapAllocator<Entry>> data_;
+		// Index in data_ of the entry of each handle, or kInvalidPosition if the handle is not in use
+		std::vector<size_t> positions_;
+		std::vector<Handle> free_handles_;
+		Comparator comparator_;
+
+		inline void Place(size_t i, Entry &&entry)
+		{
+			positions_[entry.handle_] = i;
+			data_[i] = std::move(entry);
+		}
+
+		void BubbleDown(size_t i)
+		{
+			size_t size = data_.size();
+			Entry entry_to_bubble_down = std::move(data_[i]);
+			size_t current_index = i;
+			while (true)
+			{
+				size_t first_child = current_index * Arity + 1;
+				if (first_child >= size)
+					break;
+				size_t last_child = std::min(first_child + Arity, size);
+				size_t min = first_child;
+				for (size_t child = first_child + 1; child < last_child; ++child)
+				{
+					if (comparator_(data_[child].value_, data_[min].value_))
+						min = child;
+				}
+				if (!comparator_(data_[min].value_, entry_to_bubble_down.value_))
+					break;
+				Place(current_index, std::move(data_[min]));
+				current_index = min;
+			}
+			Place(current_index, std::move(entry_to_bubble_down));
+		}
+
+		// Returns the final position of the entry
+		size_t BubbleUp(size_t i)
+		{
+			Entry entry_to_bubble_up = std::move(data_[i]);
+			size_t child = i;
+			while (child > 0)
+			{
+				size_t parent = (child - 1) / Arity;
+				if (!comparator_(entry_to_bubble_up.value_, data_[parent].value_))
+					break;
+				Place(child, std::move(data_[parent]));
+				child = parent;
+			}
+			Place(child, std::move(entry_to_bubble_up));
+			return child;
+		}
+
+		// Removes the entry at index i and fills the gap with the last entry
+		void RemoveAt(size_t i)
+		{
+			Handle handle = data_[i].handle_;
+			positions_[handle] = kInvalidPosition;
+			free_handles_.push_back(handle);
+			if (i + 1 < data_.size())
+			{
+				Place(i, std::move(data_.back()));
+				data_.pop_back();
+				if (BubbleUp(i) == i)
+					BubbleDown(i);
+			}
+			else
+				data_.pop_back();
+		}
+
+		Handle NewHandle()
+		{
+			if (free_handles_.empty())
+			{
+				positions_.push_back(kInvalidPosition);
+				return positions_.size() - 1;
+			}
+			Handle handle = free_handles_.back();
+			free_handles_.pop_back();
+			return handle;
+		}
+
+	public:
+		IndexedHeap()	{}
+		explicit IndexedHeap(const Comparator &comparator) : comparator_(comparator)	{}
+
+		// Inserts e and returns its handle
+		Handle Push(const T &e)
+		{
+			Handle handle = NewHandle();
+			data_.push_back(Entry(e, handle));
+			BubbleUp(data_.size() - 1);
+			return handle;
+		}
+
+		Handle Push(T &&e)
+		{
+			Handle handle = NewHandle();
+			data_.push_back(Entry(std::move(e), handle));
+			BubbleUp(data_.size() - 1);
+			return handle;
+		}
+
 		void Pop(T &e)
 		{
-			e = data_[0];
-			data_[0] = data_[data_.size() - 1];
-			data_.pop_back();
-			BubbleDown(0);
+			e = std::move(data_[0].value_);
+			RemoveAt(0);
+		}
+
+		// Replaces the element of 'handle' with e, which must not go after it with regards to Comparator
+		void DecreaseKey(Handle handle, const T &e)
+		{
+			size_t i = positions_[handle];
+			data_[i].value_ = e;
+			BubbleUp(i);
 		}
 
-		inline bool IsEmpty()
+		// Replaces the element of 'handle' with e, which must not go before it with regards to Comparator
+		void IncreaseKey(Handle handle, const T &e)
 		{
-			return data_.empty();
+			size_t i = positions_[handle];
+			data_[i].value_ = e;
+			BubbleDown(i);
 		}
+
+		// Replaces the element of 'handle' with e
+		void Update(Handle handle, const T &e)
+		{
+			size_t i = positions_[handle];
+			data_[i].value_ = e;
+			if (BubbleUp(i) == i)
+				BubbleDown(i);
+		}
+
+		void Erase(Handle handle)
+		{
+			RemoveAt(positions_[handle]);
+		}
+
+		// Returns true if 'handle' refers to an element which is still in the heap
+		inline bool Contains(Handle handle)	const	{ return handle < positions_.size() && positions_[handle] != kInvalidPosition; }
+		inline const T &Get(Handle handle)	const	{ return data_[positions_[handle]].value_; }
+		// Returns the minimum element in constant time
+		inline const T &Top()	const	{ return data_[0].value_; }
+		inline Handle TopHandle()	const	{ return data_[0].handle_; }
+		inline size_t Size()	const	{ return data_.size(); }
+		inline bool IsEmpty()	const	{ return data_.empty(); }
 	};
+
+	template<typename T, typename Comparator, unsigned int Arity>
+	const size_t IndexedHeap<T, Comparator, Arity>::kInvalidPosition;
 };
 
 #endif
\ No newline at end of file
@@ -14,6 +14,9 @@
 // The first step builds the Euler tour representation of the input tree. Then RMQ is applied on the array of the node levels,
 // ordered as in the Euler tour representation. Let R denote the array with the position of the first occurrence of a node
 // in the Euler tour. Then LCA(n1, n2) = Node whose index is RMQ_level(R[n1], R[n2]).
+// The tree is either made of LCANode objects, or given as flat arrays of integer node ids 0..n-1 (parent of each node, or
+// children of each node in CSR form). The flat form is walked iteratively and R is a plain array, so large and deep trees
+// are handled without hashing nor recursion.
 // https://www.topcoder.com/community/data-science/data-science-tutorials/range-minimum-query-and-lowest-common-ancestor/
 namespace Yui
 {
@@ -76,7 +79,50 @@ namespace Yui
 	}
 
 
-	template<class T>
+	// Input: tree of num_nodes nodes rooted at 'root', where the children of node u are children[child_offsets[u]],
+	// ..., children[child_offsets[u+1]-1]. It is not checked whether the input is a tree or not!
+	// Output: the ordered list of node ids in the Euler tour starting from 'root', array of the levels of each node in the
+	// Euler tour, index in euler_tour_nodes of the first occurrence of each node (-1 for the nodes not under 'root')
+	inline void EulerTour(const int *child_offsets, const int *children, int num_nodes, int root, std::vector<int> &euler_tour_nodes, std::vector<int> &levels, std::vector<int> &first_occurences_in_tour)
+	{
+		first_occurences_in_tour.assign(num_nodes, -1);
+		if (num_nodes == 0)
+			return;
+		euler_tour_nodes.reserve(euler_tour_nodes.size() + 2 * num_nodes - 1);
+		levels.reserve(levels.size() + 2 * num_nodes - 1);
+		// Path from the root to the current node, with the offset of the next child to visit of each node
+		std::vector<std::pair<int, int>> stack;
+		stack.push_back(std::make_pair(root, child_offsets[root]));
+		first_occurences_in_tour[root] = int(euler_tour_nodes.size());
+		euler_tour_nodes.push_back(root);
+		levels.push_back(0);
+		while (!stack.empty())
+		{
+			int node = stack.back().first;
+			int next_child = stack.back().second;
+			if (next_child < child_offsets[node + 1])
+			{
+				int child = children[next_child];
+				stack.back().second = next_child + 1;
+				first_occurences_in_tour[child] = int(euler_tour_nodes.size());
+				euler_tour_nodes.push_back(child);
+				levels.push_back(int(stack.size()));
+				stack.push_back(std::make_pair(child, child_offsets[child]));
+			}
+			else
+			{
+				stack.pop_back();
+				// Back to the parent
+				if (!stack.empty())
+				{
+					euler_tour_nodes.push_back(stack.back().first);
+					levels.push_back(int(stack.size()) - 1);
+				}
+			}
+		}
+	}
+
+	template<class T = int>
 	class LowestCommonAncestor
 	{
 		typedef	_LCA_FIRST_OCCURRENCE_MAP_TYPE<LCANode<T>*, int> FirstOccurrenceMap;
@@ -87,8 +133,17 @@ namespace Yui
 		std::vector<int> levels_;
 		// Index in euler_tour_nodes of the first occurrence for each node of the tree
 		FirstOccurrenceMap first_occurences_in_tour_;
+		// Same as euler_tour_nodes_ and first_occurences_in_tour_ for the trees of integer node ids
+		std::vector<int> euler_tour_ids_;
+		std::vector<int> first_occurences_of_ids_;
 		RestrictedRMQ *RMQ_;
 
+		void BuildFromCSR(const int *child_offsets, const int *children, int num_nodes, int root)
+		{
+			EulerTour(child_offsets, children, num_nodes, root, euler_tour_ids_, levels_, first_occurences_of_ids_);
+			RMQ_ = new RestrictedRMQ(levels_.data(), int(levels_.size()));
+		}
+
 	public:
 		LowestCommonAncestor(const LCANode<T> *root)
 		{
@@ -96,9 +151,43 @@ namespace Yui
 			RMQ_ = new RestrictedRMQ(&levels_[0], levels_.size());
 		}
 
+		// Tree of num_nodes nodes where parents[u] is the parent of node u, and -1 for the root
+		LowestCommonAncestor(const int *parents, int num_nodes)
+		{
+			// Children of each node in CSR form, by counting sort on the parents
+			std::vector<int> child_offsets(num_nodes + 1, 0);
+			int root = -1;
+			for (int u = 0; u < num_nodes; ++u)
+			{
+				if (parents[u] < 0)
+					root = u;
+				else
+					++child_offsets[parents[u] + 1];
+			}
+			for (int u = 0; u < num_nodes; ++u)
+				child_offsets[u + 1] += child_offsets[u];
+			std::vector<int> children(_MAX(num_nodes - 1, 0));
+			std::vector<int> next_child(child_offsets.begin(), child_offsets.end() - 1);
+			for (int u = 0; u < num_nodes; ++u)
+			{
+				if (parents[u] >= 0)
+					children[next_child[parents[u]]++] = u;
+			}
+			BuildFromCSR(child_offsets.data(), children.data(), (root < 0 ? 0 : num_nodes), root);
+		}
+
+		// Tree of num_nodes nodes rooted at 'root', where the children of node u are children[child_offsets[u]], ...,
+		// children[child_offsets[u+1]-1]
+		LowestCommonAncestor(const int *child_offsets, const int *children, int num_nodes, int root)
+		{
+			BuildFromCSR(child_offsets, children, num_nodes, root);
+		}
+
 		~LowestCommonAncestor()	{ delete RMQ_; }
 
 		inline LCANode<T> *LCA(LCANode<T> *n1, LCANode<T> *n2) { return euler_tour_nodes_[RMQ_->MinInRange(first_occurences_in_tour_[n1], first_occurences_in_tour_[n2])]; }
+		// Trees of integer node ids
+		inline int LCA(int u, int v)	const	{ return euler_tour_ids_[RMQ_->MinInRange(first_occurences_of_ids_[u], first_occurences_of_ids_[v])]; }
 	};
 }
 
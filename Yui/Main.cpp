@@ -2,6 +2,7 @@
 #include "Sort.h"
 #include "RadixTree.h"
 #include "RBTree.h"
+#include "BPlusTree.h"
 #include "DamerauLevenshteinDistance.h"
 #include "HanoiTower.h"
 #include "EggDroppingPuzzle.h"
@@ -9,6 +10,10 @@
 #include "StringSearching.h"
 #include "SegmentTree.h"
 #include "LowestCommonAncestor.h"
+#include "RangeMinimumQuery.h"
+#include "ConcurrentPriorityQueue.h"
+#include "ConcurrentSkipList.h"
+#include "PersistentRBTree.h"
 
 #include <iostream>
 #include <vector>
@@ -17,6 +22,8 @@
 #include <iterator>
 #include <omp.h>
 #include <chrono>
+#include <climits>
+#include <mutex>
 
 #define __NUM_ELEMENTS	10000000
 
@@ -93,6 +100,48 @@ int main()
 
 	std::cout << "Time elapsed for MergeSort " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
 
+	std::vector<int> test_radix_v(array, array + __NUM_ELEMENTS);
+	t_start = std::chrono::high_resolution_clock::now();
+	Yui::RadixSort(test_radix_v.begin(), test_radix_v.end(), 2);
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for RadixSort " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+	std::vector<int> test_sample_v(array, array + __NUM_ELEMENTS);
+	t_start = std::chrono::high_resolution_clock::now();
+	Yui::SampleSort(test_sample_v.begin(), test_sample_v.end(), 2);
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for SampleSort " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+	std::vector<int> test_std_v(array, array + __NUM_ELEMENTS);
+	t_start = std::chrono::high_resolution_clock::now();
+	std::sort(test_std_v.begin(), test_std_v.end());
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for std::sort " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+	std::vector<int> test_heap_v(array, array + __NUM_ELEMENTS);
+	t_start = std::chrono::high_resolution_clock::now();
+	Yui::HeapSort(test_heap_v.begin(), test_heap_v.end(), std::less<int>(), 2);
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for HeapSort " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+	std::vector<Yui::RadixTree::String> words;
+	std::wifstream words_file("..\\SCOWL\\english-words.50");
+	Yui::RadixTree::String word;
+	while (words_file >> word)
+		words.push_back(word);
+	std::vector<Yui::RadixTree::String> words_copy(words);
+	t_start = std::chrono::high_resolution_clock::now();
+	Yui::MSDRadixSort(words.begin(), words.end(), 2);
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for MSDRadixSort " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+	t_start = std::chrono::high_resolution_clock::now();
+	Yui::MergeSort(words_copy.begin(), words_copy.end(), 2);
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for MergeSort on strings " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+	Yui::RadixTree sorted_radix_tree;
+	for (auto &w : words)
+		sorted_radix_tree.Insert(w);
+
 	
 	int num_tries = EggDroppingPuzzle::SolveDP(2, 20);
 	HanoiTower hanoi(HanoiTower::Left, 6);
@@ -118,6 +167,486 @@ int main()
 	while (!heap.IsEmpty())
 		heap.Pop(t);
 
+	// Dijkstra on a synthetic graph: lazy deletion of stale entries with a binary Yui::Heap against DecreaseKey with a 4-ary
+	// Yui::IndexedHeap
+	const int kNumVertices = 100000;
+	const int kNumEdges = 1000000;
+	std::vector<std::vector<std::pair<int, int>>> graph(kNumVertices);
+	for (int e = 0; e < kNumEdges; ++e)
+		graph[rand() % kNumVertices].push_back(std::make_pair(rand() % kNumVertices, 1 + rand() % 1000));
+
+	t_start = std::chrono::high_resolution_clock::now();
+	std::vector<long long> distances(kNumVertices, LLONG_MAX);
+	Yui::Heap<std::pair<long long, int>> lazy_heap;
+	distances[0] = 0;
+	lazy_heap.Push(std::make_pair(0LL, 0));
+	while (!lazy_heap.IsEmpty())
+	{
+		std::pair<long long, int> top;
+		lazy_heap.Pop(top);
+		if (top.first > distances[top.second])
+			continue;
+		for (auto &edge : graph[top.second])
+		{
+			long long distance = top.first + edge.second;
+			if (distance < distances[edge.first])
+			{
+				distances[edge.first] = distance;
+				lazy_heap.Push(std::make_pair(distance, edge.first));
+			}
+		}
+	}
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for Dijkstra with Heap " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+	t_start = std::chrono::high_resolution_clock::now();
+	typedef Yui::IndexedHeap<std::pair<long long, int>, std::less<std::pair<long long, int>>, 4> DijkstraHeap;
+	std::vector<long long> indexed_distances(kNumVertices, LLONG_MAX);
+	std::vector<DijkstraHeap::Handle> handles(kNumVertices, DijkstraHeap::kInvalidPosition);
+	DijkstraHeap indexed_heap;
+	indexed_distances[0] = 0;
+	handles[0] = indexed_heap.Push(std::make_pair(0LL, 0));
+	while (!indexed_heap.IsEmpty())
+	{
+		std::pair<long long, int> top;
+		indexed_heap.Pop(top);
+		handles[top.second] = DijkstraHeap::kInvalidPosition;
+		for (auto &edge : graph[top.second])
+		{
+			long long distance = top.first + edge.second;
+			if (distance < indexed_distances[edge.first])
+			{
+				indexed_distances[edge.first] = distance;
+				if (handles[edge.first] == DijkstraHeap::kInvalidPosition)
+					handles[edge.first] = indexed_heap.Push(std::make_pair(distance, edge.first));
+				else
+					indexed_heap.DecreaseKey(handles[edge.first], std::make_pair(distance, edge.first));
+			}
+		}
+	}
+	t_end = std::chrono::high_resolution_clock::now();
+	std::cout << "Time elapsed for Dijkstra with IndexedHeap " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+	// Throughput of a mutex-protected Yui::Heap against Yui::MultiQueue, each thread alternating Push and TryPop
+	for (int num_threads = 1; num_threads <= omp_get_max_threads(); num_threads <<= 1)
+	{
+		const int kNumOperations = 10000000;
+		std::mutex heap_mutex;
+		Yui::Heap<int> locked_heap;
+		Yui::MultiQueue<int> multi_queue(num_threads);
+		for (int i = 0; i < 100000; ++i)
+		{
+			locked_heap.Push(array[i]);
+			multi_queue.Push(array[i]);
+		}
+
+		t_start = std::chrono::high_resolution_clock::now();
+		#pragma omp parallel num_threads(num_threads)
+		{
+			int e;
+			for (int i = omp_get_thread_num(); i < kNumOperations; i += num_threads)
+			{
+				{
+					std::lock_guard<std::mutex> lock(heap_mutex);
+					locked_heap.Push(array[i % __NUM_ELEMENTS]);
+				}
+				std::lock_guard<std::mutex> lock(heap_mutex);
+				locked_heap.Pop(e);
+			}
+		}
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for mutex Heap with " << num_threads << " threads " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+		t_start = std::chrono::high_resolution_clock::now();
+		#pragma omp parallel num_threads(num_threads)
+		{
+			int e;
+			for (int i = omp_get_thread_num(); i < kNumOperations; i += num_threads)
+			{
+				multi_queue.Push(array[i % __NUM_ELEMENTS]);
+				multi_queue.TryPop(e);
+			}
+		}
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for MultiQueue with " << num_threads << " threads " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+	}
+
+	// RBTree insertion and deletion throughput, and memory per element of the pool-allocated nodes
+	{
+		RBTree<int> rb_tree;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			rb_tree.Insert(array[i]);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::Insert " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms, "
+			<< double(rb_tree.AllocatedBytes()) / rb_tree.Size() << " bytes per element\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			rb_tree.Delete(rb_tree.Find(array[i]));
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::Delete " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+	}
+
+	// RBTree bulk loading from sorted input, and parallel bulk insertion of a sorted batch with the join-based Union
+	{
+		std::vector<int> sorted_v(array, array + __NUM_ELEMENTS);
+		std::sort(sorted_v.begin(), sorted_v.end());
+		RBTree<int> rb_tree;
+		t_start = std::chrono::high_resolution_clock::now();
+		rb_tree.BuildFromSorted(sorted_v.begin(), sorted_v.end() - __NUM_ELEMENTS / 10);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::BuildFromSorted " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		rb_tree.InsertSorted(sorted_v.end() - __NUM_ELEMENTS / 10, sorted_v.end(), 4);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::InsertSorted " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		RBTree<int> right_tree;
+		rb_tree.Split(__NUM_ELEMENTS / 2, right_tree);
+		rb_tree.Join(right_tree);
+	}
+
+	// kNumSnapshots snapshots taken at regular intervals of the insertions: deep copy of an RBTree against a version of
+	// Yui::PersistentRBTree. Keeping all the deep copies would need kNumSnapshots trees of up to __NUM_ELEMENTS nodes, so
+	// each copy is deleted right away and only the time of the copies is measured, whereas all the persistent versions are
+	// kept since they share their nodes.
+	{
+		const int kNumSnapshots = 100;
+		const int kSnapshotInterval = __NUM_ELEMENTS / kNumSnapshots;
+		RBTree<int> rb_tree;
+		double copy_time = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+		{
+			if (!rb_tree.Find(array[i]))
+				rb_tree.Insert(array[i]);
+			if (i % kSnapshotInterval == kSnapshotInterval - 1)
+			{
+				auto t_copy_start = std::chrono::high_resolution_clock::now();
+				RBTree<int> *rb_snapshot = new RBTree<int>();
+				rb_snapshot->BuildFromSorted(rb_tree.begin(), rb_tree.end());
+				copy_time += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t_copy_start).count();
+				delete rb_snapshot;
+			}
+		}
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree with " << kNumSnapshots << " deep copies " << std::chrono::duration<double, std::milli>(t_end - t_start).count()
+			<< " ms, of which " << copy_time << " ms of copies\n";
+
+		Yui::PersistentRBTree<int> persistent_tree;
+		std::vector<Yui::PersistentRBTree<int>> versions;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+		{
+			persistent_tree = persistent_tree.Insert(array[i]);
+			if (i % kSnapshotInterval == kSnapshotInterval - 1)
+				versions.push_back(persistent_tree);
+		}
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for PersistentRBTree with " << kNumSnapshots << " versions " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+	}
+
+	// Insertions, point lookups and range scans on Yui::BPlusTree against RBTree, on the first kNumTreeElements shuffled keys
+	{
+		const int kNumTreeElements = 2000000;
+		RBTree<int> rb_tree;
+		Yui::BPlusTree<int> b_plus_tree;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < kNumTreeElements; ++i)
+			rb_tree.Insert(array[i]);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::Insert " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < kNumTreeElements; ++i)
+			b_plus_tree.Insert(array[i]);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for BPlusTree::Insert " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		std::cout << double(rb_tree.AllocatedBytes()) / rb_tree.Size() << " bytes per element in RBTree, "
+			<< double(b_plus_tree.AllocatedBytes()) / b_plus_tree.Size() << " in BPlusTree\n";
+
+		long long checksum = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < kNumTreeElements; ++i)
+			checksum += rb_tree.Find(array[i])->data();
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::Find " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < kNumTreeElements; ++i)
+			checksum += *b_plus_tree.Find(array[i]);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for BPlusTree::Find " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+		// Ranges of 1000 keys: in-order walk from the lower bound in RBTree, scan of the linked leaves in BPlusTree
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 10000; ++i)
+			rb_tree.ForEachInRange(array[i], array[i] + 1000, [&checksum](int e) { checksum += e; });
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RBTree::ForEachInRange " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 10000; ++i)
+			b_plus_tree.ForEachInRange(array[i], array[i] + 1000, [&checksum](int e) { checksum += e; });
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for BPlusTree::ForEachInRange " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms (" << checksum << ")\n";
+	}
+
+	// Throughput of a mutex-protected RBTree against Yui::ConcurrentSkipList with 90%, 50% and 10% of lookups, the rest
+	// being insertions and deletions in equal parts
+	for (int read_percent = 90; read_percent > 0; read_percent -= 40)
+	{
+		for (int num_threads = 1; num_threads <= omp_get_max_threads(); num_threads <<= 1)
+		{
+			const int kNumOperations = 10000000;
+			std::mutex tree_mutex;
+			RBTree<int> locked_tree;
+			Yui::ConcurrentSkipList<int> skip_list;
+			for (int i = 0; i < __NUM_ELEMENTS; i += 2)
+			{
+				if (!locked_tree.Find(array[i]))
+					locked_tree.Insert(array[i]);
+				skip_list.Insert(array[i]);
+			}
+
+			t_start = std::chrono::high_resolution_clock::now();
+			#pragma omp parallel num_threads(num_threads)
+			{
+				for (int i = omp_get_thread_num(); i < kNumOperations; i += num_threads)
+				{
+					int e = array[i % __NUM_ELEMENTS];
+					int op = i % 100;
+					std::lock_guard<std::mutex> lock(tree_mutex);
+					auto n = locked_tree.Find(e);
+					if (op < read_percent)
+						continue;
+					if (op % 2 == 0 && !n)
+						locked_tree.Insert(e);
+					else if (op % 2 == 1 && n)
+						locked_tree.Delete(n);
+				}
+			}
+			t_end = std::chrono::high_resolution_clock::now();
+			std::cout << "Time elapsed for mutex RBTree with " << read_percent << "% reads and " << num_threads << " threads "
+				<< std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+			t_start = std::chrono::high_resolution_clock::now();
+			#pragma omp parallel num_threads(num_threads)
+			{
+				for (int i = omp_get_thread_num(); i < kNumOperations; i += num_threads)
+				{
+					int e = array[i % __NUM_ELEMENTS];
+					int op = i % 100;
+					if (op < read_percent)
+						skip_list.Contains(e);
+					else if (op % 2 == 0)
+						skip_list.Insert(e);
+					else
+						skip_list.Erase(e);
+				}
+			}
+			t_end = std::chrono::high_resolution_clock::now();
+			std::cout << "Time elapsed for ConcurrentSkipList with " << read_percent << "% reads and " << num_threads << " threads "
+				<< std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		}
+	}
+
+	// SparseTableRMQ construction on 10^6 and 10^7 elements with 1 to all threads. 10^8 elements would need a table of
+	// 27 levels of 10^8 int indices (10.8 GB).
+	for (int size = __NUM_ELEMENTS / 10; size <= __NUM_ELEMENTS; size *= 10)
+	{
+		for (int num_threads = 1; num_threads <= omp_get_max_threads(); num_threads <<= 1)
+		{
+			t_start = std::chrono::high_resolution_clock::now();
+			Yui::SparseTableRMQ<int> sparse_table(array, size, num_threads);
+			t_end = std::chrono::high_resolution_clock::now();
+			std::cout << "Time elapsed for SparseTableRMQ construction on " << size << " elements with " << num_threads << " threads "
+				<< std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		}
+	}
+
+	// SparseTableRMQ construction and query throughput on __NUM_ELEMENTS elements
+	{
+		std::vector<std::pair<int, int>> queries(__NUM_ELEMENTS);
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			queries[i] = std::make_pair(array[i] - 1, array[(i + 1) % __NUM_ELEMENTS] - 1);
+		t_start = std::chrono::high_resolution_clock::now();
+		Yui::SparseTableRMQ<int> sparse_table(array, __NUM_ELEMENTS);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for SparseTableRMQ construction " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms, "
+			<< sparse_table.AllocatedBytes() / (1024 * 1024) << " MB\n";
+		long long checksum = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			checksum += sparse_table.MinInRange(queries[i].first, queries[i].second);
+		t_end = std::chrono::high_resolution_clock::now();
+		double elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for SparseTableRMQ::MinInRange " << elapsed << " ms, " << __NUM_ELEMENTS / elapsed * 1000 << " queries/s (" << checksum << ")\n";
+
+		// Batches of queries with prefetching, with 1 to all threads
+		std::vector<int> results(__NUM_ELEMENTS);
+		for (int num_threads = 1; num_threads <= omp_get_max_threads(); num_threads <<= 1)
+		{
+			t_start = std::chrono::high_resolution_clock::now();
+			sparse_table.MinInRangeBatch(&queries[0], queries.size(), &results[0], num_threads);
+			t_end = std::chrono::high_resolution_clock::now();
+			elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+			std::cout << "Time elapsed for SparseTableRMQ::MinInRangeBatch with " << num_threads << " threads " << elapsed << " ms, "
+				<< __NUM_ELEMENTS / elapsed * 1000 << " queries/s\n";
+		}
+
+		// SuccinctRMQ on the same elements and queries: memory against query latency
+		t_start = std::chrono::high_resolution_clock::now();
+		Yui::SuccinctRMQ succinct(array, __NUM_ELEMENTS);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for SuccinctRMQ construction " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms, "
+			<< succinct.AllocatedBytes() / (1024 * 1024) << " MB (" << 8.0 * succinct.AllocatedBytes() / __NUM_ELEMENTS << " bits per element)\n";
+		checksum = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			checksum += succinct.MinInRange(queries[i].first, queries[i].second);
+		t_end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for SuccinctRMQ::MinInRange " << elapsed << " ms, " << __NUM_ELEMENTS / elapsed * 1000 << " queries/s (" << checksum << ")\n";
+
+		// DynamicRMQ on the same elements and queries, then single and bulk updates. A static table would be rebuilt instead.
+		t_start = std::chrono::high_resolution_clock::now();
+		Yui::DynamicRMQ<int> dynamic(array, __NUM_ELEMENTS);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for DynamicRMQ construction " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms, "
+			<< dynamic.AllocatedBytes() / (1024 * 1024) << " MB\n";
+		checksum = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			checksum += dynamic.MinInRange(queries[i].first, queries[i].second);
+		t_end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for DynamicRMQ::MinInRange " << elapsed << " ms, " << __NUM_ELEMENTS / elapsed * 1000 << " queries/s (" << checksum << ")\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			dynamic.Update(queries[i].first, array[i]);
+		t_end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for DynamicRMQ::Update " << elapsed << " ms, " << __NUM_ELEMENTS / elapsed * 1000 << " updates/s\n";
+		std::vector<std::pair<int, int>> updates(__NUM_ELEMENTS / 10);
+		for (size_t i = 0; i < updates.size(); ++i)
+			updates[i] = std::make_pair(queries[i].second, array[i]);
+		t_start = std::chrono::high_resolution_clock::now();
+		dynamic.Update(&updates[0], updates.size());
+		t_end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for DynamicRMQ bulk Update of " << updates.size() << " elements " << elapsed << " ms, "
+			<< updates.size() / elapsed * 1000 << " updates/s\n";
+
+		// RestrictedRMQ on a random walk of __NUM_ELEMENTS steps of +1 or -1, with the same queries
+		std::vector<int> walk(__NUM_ELEMENTS);
+		for (int i = 1; i < __NUM_ELEMENTS; ++i)
+			walk[i] = walk[i - 1] + ((array[i] & 1) ? 1 : -1);
+		t_start = std::chrono::high_resolution_clock::now();
+		Yui::RestrictedRMQ restricted(&walk[0], __NUM_ELEMENTS);
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for RestrictedRMQ construction " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms, "
+			<< restricted.AllocatedBytes() / (1024 * 1024) << " MB\n";
+		checksum = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			checksum += restricted.MinInRange(queries[i].first, queries[i].second);
+		t_end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for RestrictedRMQ::MinInRange " << elapsed << " ms, " << __NUM_ELEMENTS / elapsed * 1000 << " queries/s (" << checksum << ")\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		restricted.MinInRangeBatch(&queries[0], queries.size(), &results[0]);
+		t_end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+		std::cout << "Time elapsed for RestrictedRMQ::MinInRangeBatch " << elapsed << " ms, " << __NUM_ELEMENTS / elapsed * 1000 << " queries/s\n";
+	}
+
+	// LowestCommonAncestor construction on a random tree of __NUM_ELEMENTS / 10 nodes, from LCANode objects and from the
+	// array of the parents
+	{
+		const int kNumNodes = __NUM_ELEMENTS / 10;
+		std::vector<int> parents(kNumNodes, -1);
+		std::vector<Yui::LCANode<int> *> nodes(kNumNodes);
+		for (int i = 0; i < kNumNodes; ++i)
+			nodes[i] = new Yui::LCANode<int>(i);
+		for (int i = 1; i < kNumNodes; ++i)
+		{
+			parents[i] = array[i] % i;
+			nodes[parents[i]]->AddChild(nodes[i]);
+		}
+		t_start = std::chrono::high_resolution_clock::now();
+		{
+			Yui::LowestCommonAncestor<int> LCA_nodes(nodes[0]);
+			t_end = std::chrono::high_resolution_clock::now();
+		}
+		std::cout << "Time elapsed for LowestCommonAncestor construction from LCANode objects " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		{
+			Yui::LowestCommonAncestor<> LCA_parents(&parents[0], kNumNodes);
+			t_end = std::chrono::high_resolution_clock::now();
+		}
+		std::cout << "Time elapsed for LowestCommonAncestor construction from the parents " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		for (int i = 0; i < kNumNodes; ++i)
+			delete nodes[i];
+	}
+
+	// BST insertion in sorted, reverse and random order, unbalanced and AVL balanced. Sorted insertions degenerate the
+	// unbalanced tree into a list, hence the smaller number of elements.
+	{
+		const int kNumElements = 20000;
+		std::vector<int> orders[3];
+		for (int i = 0; i < kNumElements; ++i)
+		{
+			orders[0].push_back(i);
+			orders[1].push_back(kNumElements - i);
+			orders[2].push_back(array[i]);
+		}
+		const char *order_names[3] = { "sorted", "reverse", "random" };
+		for (int order = 0; order < 3; ++order)
+		{
+			Yui::BST<int> bst;
+			t_start = std::chrono::high_resolution_clock::now();
+			for (int e : orders[order])
+				bst.Insert(e);
+			for (int e : orders[order])
+				bst.Find(e);
+			t_end = std::chrono::high_resolution_clock::now();
+			std::cout << "Time elapsed for BST Insert and Find in " << order_names[order] << " order " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+
+			Yui::BST<int, Yui::BSTAVLBalancing> avl_tree;
+			t_start = std::chrono::high_resolution_clock::now();
+			for (int e : orders[order])
+				avl_tree.Insert(e);
+			for (int e : orders[order])
+				avl_tree.Find(e);
+			t_end = std::chrono::high_resolution_clock::now();
+			std::cout << "Time elapsed for AVL BST Insert and Find in " << order_names[order] << " order " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		}
+	}
+
+	// AVL balanced BST against CompactBST (32-bit indices into a vector of nodes): insertion, lookups and in-order traversal
+	// along the successor list
+	{
+		Yui::BST<int, Yui::BSTAVLBalancing> avl_tree;
+		Yui::CompactBST<int, Yui::BSTAVLBalancing> compact_tree;
+		long long checksum = 0;
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			avl_tree.Insert(array[i]);
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			checksum += avl_tree.Find(array[i])->data();
+		for (int e : avl_tree)
+			checksum += e;
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for AVL BST " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms\n";
+		t_start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			compact_tree.Insert(array[i]);
+		for (int i = 0; i < __NUM_ELEMENTS; ++i)
+			checksum += compact_tree.data(compact_tree.Find(array[i]));
+		for (int e : compact_tree)
+			checksum += e;
+		t_end = std::chrono::high_resolution_clock::now();
+		std::cout << "Time elapsed for AVL CompactBST " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms, "
+			<< double(compact_tree.AllocatedBytes()) / compact_tree.Size() << " bytes per element (" << checksum << ")\n";
+	}
+
 	Yui::BST<Test> test;
 	test.Insert(Test(0));
 	test.Insert(Test(-1));
@@ -145,6 +674,13 @@ int main()
 	auto n_RBTree_min = RBtree.GetMin(RBtree.root());
 	auto n_RBTree_max = RBtree.GetMax(RBtree.root());
 	RBtree.Delete(RBtree.root());
+
+	RBTree<int, RBTreeAggregate<RBTreeSumMonoid<long long>>> sum_tree;
+	for (int i = 0; i < 100; ++i)
+		sum_tree.Insert(i);
+	size_t rank = sum_tree.Rank(42);
+	auto n_median = sum_tree.Select(sum_tree.Size() / 2);
+	long long range_sum = sum_tree.RangeAggregate(10, 19);
 #endif
 
 	Yui::RadixTree radix_tree;
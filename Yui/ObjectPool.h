@@ -0,0 +1,104 @@
+#ifndef __OBJECT_POOL_H__
+#define __OBJECT_POOL_H__
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+
+#define __OBJECT_POOL_MAX_SLAB_SIZE	65536
+
+namespace Yui
+{
+	// Slab allocator for objects of type T. Objects are carved out of slabs whose size doubles up to __OBJECT_POOL_MAX_SLAB_SIZE
+	// objects, and released objects are kept in a free list threaded through their own storage, so that allocation and
+	// release are O(1) without calling the global allocator. Node-based containers owning a pool get their nodes packed in
+	// a few large blocks instead of scattered in the heap. Not thread safe.
+	template<typename T>
+	class ObjectPool
+	{
+	private:
+		// Storage for one T, or the link of the free list while the slot is released. VS2013 supports neither alignas nor
+		// unions of non-trivial members, hence std::aligned_storage large and aligned enough for both.
+		typedef typename std::aligned_storage<(sizeof(T) > sizeof(void *) ? sizeof(T) : sizeof(void *)),
+			(std::alignment_of<T>::value > std::alignment_of<void *>::value ? std::alignment_of<T>::value : std::alignment_of<void *>::value)>::type Slot;
+
+		static inline Slot *&Next(Slot *slot)	{ return *reinterpret_cast<Slot **>(slot); }
+
+		std::vector<Slot *> slabs_;
+		Slot *free_list_ = nullptr;
+		// Unused part of the last slab
+		Slot *current_ = nullptr;
+		size_t remaining_ = 0;
+		size_t next_slab_size_;
+		size_t capacity_ = 0;
+
+		void NewSlab()
+		{
+			slabs_.push_back(new Slot[next_slab_size_]);
+			current_ = slabs_.back();
+			remaining_ = next_slab_size_;
+			capacity_ += next_slab_size_;
+			next_slab_size_ = std::min<size_t>(next_slab_size_ << 1, __OBJECT_POOL_MAX_SLAB_SIZE);
+		}
+
+	public:
+		explicit ObjectPool(size_t initial_slab_size = 64) : next_slab_size_(std::max<size_t>(initial_slab_size, 1))	{}
+		// Objects still allocated are not destroyed
+		~ObjectPool()	{ Clear(); }
+
+		ObjectPool(const ObjectPool &) = delete;
+		ObjectPool &operator=(const ObjectPool &) = delete;
+
+		// Returns uninitialized storage for one T
+		void *Allocate()
+		{
+			if (free_list_)
+			{
+				Slot *slot = free_list_;
+				free_list_ = Next(slot);
+				return slot;
+			}
+			if (remaining_ == 0)
+				NewSlab();
+			--remaining_;
+			return current_++;
+		}
+
+		void Deallocate(void *p)
+		{
+			Slot *slot = static_cast<Slot *>(p);
+			Next(slot) = free_list_;
+			free_list_ = slot;
+		}
+
+		template<typename... Args>
+		inline T *New(Args&&... args)	{ return ::new(Allocate()) T(std::forward<Args>(args)...); }
+
+		inline void Delete(T *p)
+		{
+			p->~T();
+			Deallocate(p);
+		}
+
+		// Releases all the slabs at once. Objects still allocated are not destroyed.
+		void Clear()
+		{
+			for (size_t i = 0; i < slabs_.size(); ++i)
+				delete[] slabs_[i];
+			slabs_.clear();
+			free_list_ = nullptr;
+			current_ = nullptr;
+			remaining_ = 0;
+			capacity_ = 0;
+		}
+
+		// Number of objects the allocated slabs can hold
+		inline size_t Capacity()	const	{ return capacity_; }
+		inline size_t AllocatedBytes()	const	{ return capacity_ * sizeof(Slot); }
+	};
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef __PERSISTENT_RB_TREE_H__
+#define __PERSISTENT_RB_TREE_H__
+
+// Persistent red-black tree: a version of the tree is never modified. Insert and Delete return a new version which copies
+// the O(log n) nodes on the path to the modified element and shares all the other subtrees with the previous version.
+// - Taking a snapshot is copying a PersistentRBTree object, in constant time.
+// - Nodes are reference counted with std::shared_ptr: a node is freed when the last version using it is destroyed, and
+//   readers of a version never block nor are blocked by a writer creating the next one. To hand versions over between
+//   threads, store them in a std::shared_ptr<const PersistentRBTree> accessed with std::atomic_load and std::atomic_store.
+// Insertion follows Okasaki (Red-black trees in a functional setting) and deletion Kahrs (Red-black trees with types).
+// Elements are unique: inserting an element equal to an existing one replaces it, which gives map semantics to elements
+// compared on a key only.
+#include <memory>
+#include <stddef.h>
+
+namespace Yui
+{
+	template<typename Element>
+	class PersistentRBTree
+	{
+	private:
+		struct Node;
+		typedef std::shared_ptr<const Node> NodePtr;
+
+		struct Node
+		{
+			bool red_;
+			Element data_;
+			NodePtr left_;
+			NodePtr right_;
+
+			Node(bool red, const NodePtr &left, const Element &e, const NodePtr &right) : red_(red), data_(e), left_(left), right_(right)	{}
+		};
+
+		static const bool kRed = true;
+		static const bool kBlack = false;
+
+		NodePtr root_;
+		size_t size_ = 0;
+
+		PersistentRBTree(const NodePtr &root, size_t size) : root_(root), size_(size)	{}
+
+		static inline NodePtr MakeNode(bool red, const NodePtr &left, const Element &e, const NodePtr &right)	{ return std::make_shared<const Node>(red, left, e, right); }
+		static inline bool IsRed(const NodePtr &n)	{ return n && n->red_; }
+		// Non-empty black node
+		static inline bool IsBlack(const NodePtr &n)	{ return n && !n->red_; }
+
+		static NodePtr Paint(const NodePtr &n, bool red)
+		{
+			if (!n || n->red_ == red)
+				return n;
+			return MakeNode(red, n->left_, n->data_, n->right_);
+		}
+
+		// Returns a tree made of a, x and b, where a or b may have a red-red violation at its root, and fixes it with a red
+		// root having two black children. Otherwise x becomes a black root.
+		static NodePtr Balance(const NodePtr &a, const Element &x, const NodePtr &b)
+		{
+			if (IsRed(a) && IsRed(b))
+				return MakeNode(kRed, Paint(a, kBlack), x, Paint(b, kBlack));
+			if (IsRed(a))
+			{
+				if (IsRed(a->left_))
+					return MakeNode(kRed, Paint(a->left_, kBlack), a->data_, MakeNode(kBlack, a->right_, x, b));
+				if (IsRed(a->right_))
+					return MakeNode(kRed, MakeNode(kBlack, a->left_, a->data_, a->right_->left_), a->right_->data_, MakeNode(kBlack, a->right_->right_, x, b));
+			}
+			if (IsRed(b))
+			{
+				if (IsRed(b->right_))
+					return MakeNode(kRed, MakeNode(kBlack, a, x, b->left_), b->data_, Paint(b->right_, kBlack));
+				if (IsRed(b->left_))
+					return MakeNode(kRed, MakeNode(kBlack, a, x, b->left_->left_), b->left_->data_, MakeNode(kBlack, b->left_->right_, b->data_, b->right_));
+			}
+			return MakeNode(kBlack, a, x, b);
+		}
+
+		static NodePtr InternalInsert(const NodePtr &n, const Element &e, bool &added)
+		{
+			if (!n)
+			{
+				added = true;
+				return MakeNode(kRed, nullptr, e, nullptr);
+			}
+			if (e < n->data_)
+			{
+				NodePtr left = InternalInsert(n->left_, e, added);
+				return n->red_ ? MakeNode(kRed, left, n->data_, n->right_) : Balance(left, n->data_, n->right_);
+			}
+			if (n->data_ < e)
+			{
+				NodePtr right = InternalInsert(n->right_, e, added);
+				return n->red_ ? MakeNode(kRed, n->left_, n->data_, right) : Balance(n->left_, n->data_, right);
+			}
+			return MakeNode(n->red_, n->left_, e, n->right_);
+		}
+
+		// Rebuilds a tree from x and its subtrees when the black height of left is one less than the one of right
+		static NodePtr BalanceLeft(const NodePtr &left, const Element &x, const NodePtr &right)
+		{
+			if (IsRed(left))
+				return MakeNode(kRed, Paint(left, kBlack), x, right);
+			if (IsBlack(right))
+				return Balance(left, x, Paint(right, kRed));
+			// right is red with black children
+			return MakeNode(kRed, MakeNode(kBlack, left, x, right->left_->left_), right->left_->data_,
+				Balance(right->left_->right_, right->data_, Paint(right->right_, kRed)));
+		}
+
+		// Rebuilds a tree from x and its subtrees when the black height of right is one less than the one of left
+		static NodePtr BalanceRight(const NodePtr &left, const Element &x, const NodePtr &right)
+		{
+			if (IsRed(right))
+				return MakeNode(kRed, left, x, Paint(right, kBlack));
+			if (IsBlack(left))
+				return Balance(Paint(left, kRed), x, right);
+			// left is red with black children
+			return MakeNode(kRed, Balance(Paint(left->left_, kRed), left->data_, left->right_->left_), left->right_->data_,
+				MakeNode(kBlack, left->right_->right_, x, right));
+		}
+
+		// Concatenates two trees of the same black height whose elements are ordered
+		static NodePtr Append(const NodePtr &a, const NodePtr &b)
+		{
+			if (!a)
+				return b;
+			if (!b)
+				return a;
+			if (IsRed(a) && IsRed(b))
+			{
+				NodePtr middle = Append(a->right_, b->left_);
+				if (IsRed(middle))
+					return MakeNode(kRed, MakeNode(kRed, a->left_, a->data_, middle->left_), middle->data_, MakeNode(kRed, middle->right_, b->data_, b->right_));
+				return MakeNode(kRed, a->left_, a->data_, MakeNode(kRed, middle, b->data_, b->right_));
+			}
+			if (IsBlack(a) && IsBlack(b))
+			{
+				NodePtr middle = Append(a->right_, b->left_);
+				if (IsRed(middle))
+					return MakeNode(kRed, MakeNode(kBlack, a->left_, a->data_, middle->left_), middle->data_, MakeNode(kBlack, middle->right_, b->data_, b->right_));
+				return BalanceLeft(a->left_, a->data_, MakeNode(kBlack, middle, b->data_, b->right_));
+			}
+			if (IsRed(b))
+				return MakeNode(kRed, Append(a, b->left_), b->data_, b->right_);
+			return MakeNode(kRed, a->left_, a->data_, Append(a->right_, b));
+		}
+
+		// Deletes e, which must be in the subtree n. The black height of the result is one less than the one of n if n is black.
+		static NodePtr InternalDelete(const NodePtr &n, const Element &e)
+		{
+			if (e < n->data_)
+			{
+				if (IsBlack(n->left_))
+					return BalanceLeft(InternalDelete(n->left_, e), n->data_, n->right_);
+				return MakeNode(kRed, InternalDelete(n->left_, e), n->data_, n->right_);
+			}
+			if (n->data_ < e)
+			{
+				if (IsBlack(n->right_))
+					return BalanceRight(n->left_, n->data_, InternalDelete(n->right_, e));
+				return MakeNode(kRed, n->left_, n->data_, InternalDelete(n->right_, e));
+			}
+			return Append(n->left_, n->right_);
+		}
+
+		template<typename F>
+		static void InternalForEachInRange(const Node *n, const Element &lo, const Element &hi, F &fn)
+		{
+			while (n)
+			{
+				if (n->data_ < lo)
+					n = n->right_.get();
+				else if (hi < n->data_)
+					n = n->left_.get();
+				else
+				{
+					InternalForEachInRange(n->left_.get(), lo, hi, fn);
+					fn(n->data_);
+					// Continue on the right subtree, iteratively
+					n = n->right_.get();
+				}
+			}
+		}
+
+	public:
+		// Empty tree
+		PersistentRBTree()	{}
+
+		// Returns the version of the tree containing e in addition to the elements of this version. O(log n).
+		PersistentRBTree Insert(const Element &e)	const
+		{
+			bool added = false;
+			NodePtr root = Paint(InternalInsert(root_, e, added), kBlack);
+			return PersistentRBTree(root, size_ + (added ? 1 : 0));
+		}
+
+		// Returns the version of the tree without e. The same version is returned if e is not in the tree. O(log n).
+		PersistentRBTree Delete(const Element &e)	const
+		{
+			if (!Find(e))
+				return *this;
+			return PersistentRBTree(Paint(InternalDelete(root_, e), kBlack), size_ - 1);
+		}
+
+		// Returns the element equal to e, or nullptr. The element lives as long as a version containing it.
+		const Element *Find(const Element &e)	const
+		{
+			const Node *n = root_.get();
+			while (n)
+			{
+				if (e < n->data_)
+					n = n->left_.get();
+				else if (n->data_ < e)
+					n = n->right_.get();
+				else
+					return &n->data_;
+			}
+			return nullptr;
+		}
+
+		const Element *GetMin()	const
+		{
+			const Node *n = root_.get();
+			if (!n)
+				return nullptr;
+			while (n->left_)
+				n = n->left_.get();
+			return &n->data_;
+		}
+
+		const Element *GetMax()	const
+		{
+			const Node *n = root_.get();
+			if (!n)
+				return nullptr;
+			while (n->right_)
+				n = n->right_.get();
+			return &n->data_;
+		}
+
+		// Calls fn(e) for each element e such that lo <= e <= hi in increasing order. O(log n + k).
+		template<typename F>
+		void ForEachInRange(const Element &lo, const Element &hi, F fn)	const
+		{
+			InternalForEachInRange(root_.get(), lo, hi, fn);
+		}
+
+		inline size_t Size()	const	{ return size_; }
+		inline bool IsEmpty()	const	{ return size_ == 0; }
+	};
+};
+
+#endif
@@ -8,510 +8,1059 @@
 // 4. Every red node must have two black child nodes.
 // 5. Every path from a given node to any of its descendant leaves contains the same number of black nodes.
 // See Wikipedia for: Redblack tree for implementation details
-template<typename Element> class RBTree
+//
+// All the nil leaves are a single black sentinel node shared by the trees of the same type and never written to, and the
+// element nodes are allocated from a Yui::ObjectPool owned by the tree: an insertion costs one pool allocation and no heap
+// allocation in the common case.
+// Split, Join and Union move whole subtrees between trees with the join-based algorithms of Blelloch, Ferizovic and Sun
+// (Just Join for Parallel Ordered Sets). The trees produced by Split share the pool of the original tree, so that their
+// nodes can be joined back in O(log n) time; trees sharing a pool must not be modified concurrently.
+#include "ObjectPool.h"
+
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+// Augmentation policies of RBTree. Each node derives from the NodeData of the policy, which is recomputed from the node's
+// element and the NodeData of its children whenever the subtree of the node changes (insertion and deletion paths,
+// rotations). The sentinel keeps a default constructed NodeData.
+
+// No additional data per node
+struct RBTreeNoAugmentation
+{
+	static const bool kEnabled = false;
+
+	template<typename Element>
+	struct NodeData
+	{
+		inline void Update(const NodeData &, const NodeData &, const Element &)	{}
+	};
+};
+
+// Size of the subtree of each node, for Rank and Select in O(log n)
+struct RBTreeOrderStatistics
+{
+	static const bool kEnabled = true;
+
+	template<typename Element>
+	struct NodeData
+	{
+		size_t size_ = 0;
+		inline void Update(const NodeData &left, const NodeData &right, const Element &)	{ size_ = left.size_ + right.size_ + 1; }
+	};
+};
+
+// Size of the subtree and aggregate of its elements in order, for Rank, Select and RangeAggregate in O(log n). Monoid provides
+// the type Value and the static functions Identity(), Lift(const Element &) and Combine(const Value &, const Value &), the
+// latter being associative but not necessarily commutative.
+template<typename M>
+struct RBTreeAggregate
+{
+	typedef M Monoid;
+	static const bool kEnabled = true;
+
+	template<typename Element>
+	struct NodeData
+	{
+		size_t size_ = 0;
+		typename Monoid::Value aggregate_ = Monoid::Identity();
+		inline void Update(const NodeData &left, const NodeData &right, const Element &e)
+		{
+			size_ = left.size_ + right.size_ + 1;
+			aggregate_ = Monoid::Combine(Monoid::Combine(left.aggregate_, Monoid::Lift(e)), right.aggregate_);
+		}
+	};
+};
+
+// Sum of the elements, for RBTreeAggregate
+template<typename Element>
+struct RBTreeSumMonoid
+{
+	typedef Element Value;
+	static inline Value Identity()	{ return Value(); }
+	static inline Value Lift(const Element &e)	{ return e; }
+	static inline Value Combine(const Value &a, const Value &b)	{ return a + b; }
+};
+
+template<typename Element, typename Augmentation = RBTreeNoAugmentation> class RBTree
 {
 private:
 	template<typename Element>
-	class Node
+	class Node : public Augmentation::template NodeData<Element>
 	{
-		friend class RBTree<Element>;
-		
+		friend class RBTree<Element, Augmentation>;
+
 	public:
 		typedef bool Color;
-		const Color kRed = true;
-		const Color kBlack = false;
+		static const Color kRed = true;
+		static const Color kBlack = false;
 
 	private:
-		Color color_ = kBlack;
-		Element data_;
 		Node *parent_;
 		Node *left_ = nullptr;
 		Node *right_ = nullptr;
+		Color color_ = kBlack;
+		// Raw storage for the element, so that the sentinel node needs no Element (VS2013 has no unrestricted unions). The
+		// element is constructed in place by the constructor below and destroyed by the tree.
+		typename std::aligned_storage<sizeof(Element), std::alignment_of<Element>::value>::type storage_;
 
-		void RotateLeft()
-		{
-			Node<Element> *saved_right = right_;
-			Node<Element> *saved_parent = parent_;
-			right_ = saved_right->left_;
-			if (right_)
-				right_->parent_ = this;		
-			parent_ = saved_right;
-			if (saved_parent)
-			{
-				if (saved_parent->left_ == this)
-					saved_parent->left_ = saved_right;
-				else
-					saved_parent->right_ = saved_right;
-			}
-			if (saved_right)
-			{
-				saved_right->left_ = this;
-				saved_right->parent_ = saved_parent;
-			}
-		}
+		inline Element &Data()	{ return *reinterpret_cast<Element *>(&storage_); }
 
-		void RotateRight()
-		{
-			Node<Element> *saved_left = left_;
-			Node<Element> *saved_parent = parent_;
-			left_ = saved_left->right_;
-			if (left_)
-				left_->parent_ = this;
-			parent_ = saved_left;
-			if (saved_parent)
-			{
-				if (saved_parent->left_ == this)
-					saved_parent->left_ = saved_left;
-				else
-					saved_parent->right_ = saved_left;
-			}
-			if (saved_left)
-			{
-				saved_left->right_ = this;
-				saved_left->parent_ = saved_parent;
-			}
-		}
+		// Nil sentinel node
+		Node() : parent_(nullptr)	{}
 
-		// Nil node
-		Node(Node *parent) : parent_(parent)	{}
 	public:
-		Node(const Element &e, Node *parent = nullptr) : data_(e), parent_(parent)
+		template<typename U>
+		Node(U &&e, Node *parent, Node *nil) : parent_(parent), left_(nil), right_(nil), color_(kRed)
 		{
-			left_ = new Node<Element>(this);
-			right_ = new Node<Element>(this);
-		}
-		Node(const Element &&e, Node *parent = nullptr) : data_(std::move(e)), parent_(parent)
-		{
-			left_ = new Node<Element>(this);
-			right_ = new Node<Element>(this);
-		}
-
-		~Node()
-		{
-			if (left_)
-			{
-				if (left_->IsLeaf())
-					delete left_;
-			}
-			if (right_)
-			{
-				if (right_->IsLeaf())
-					delete right_;
-			}
+			::new(&storage_) Element(std::forward<U>(e));
 		}
 
 		inline Node *left()	const	{ return left_; }
 		inline Node *right()	const	{ return right_; }
 		inline Node *parent()	const	{ return parent_; }
-		inline const Element &data()	const	{ return data_; }
+		inline const Element &data()	const	{ return *reinterpret_cast<const Element *>(&storage_); }
 		inline Color color()	const	{ return color_; }
 		inline bool IsBlack()	const	{ return color_ == kBlack; }
 		inline bool IsRed()	const	{ return color_ == kRed; }
 		inline void PaintInBlack()	{ color_ = kBlack; }
 		inline void PaintInRed()	{ color_ = kRed; }
+		// Only the sentinel has no children
 		inline bool IsLeaf() const	{ return !(left_ || right_); }
 	};
-	
-	Node<Element> *root_ = nullptr;
 
-	// Returns the sibling of n's parent node
-	Node<Element> *FindUncle(Node<Element> *n)
+	typedef Yui::ObjectPool<Node<Element>> Pool;
+
+	static Node<Element> *Nil()
 	{
-		if (n->parent_)
-		{
-			Node<Element> *grand_parent = n->parent_->parent_;
-			if (grand_parent)
-			{
-				if (grand_parent->left_ == n->parent_)
-					return grand_parent->right_;
-				else
-					return grand_parent->left_;
-			}
-			else
-				return nullptr;
-		}
-		else
-			return nullptr;
+		static Node<Element> nil;
+		return &nil;
 	}
 
-	Node<Element> *FindSibling(Node<Element> *n)
+	// Shared with the trees produced by Split
+	std::shared_ptr<Pool> pool_ = std::make_shared<Pool>();
+	Node<Element> *nil_ = Nil();
+	Node<Element> *root_ = nil_;
+	size_t size_ = 0;
+
+	typedef typename Augmentation::template NodeData<Element> NodeData;
+
+	inline void Update(Node<Element> *n)
 	{
-		Node<Element> *n_parent = n->parent();
-		if (n_parent)
-		{
-			if (n_parent->left() == n)
-				return n_parent->right();
-			else
-				return n_parent->left();
-		}
-		else
-			return nullptr;
+		n->NodeData::Update(*n->left_, *n->right_, n->Data());
 	}
 
-	// Action taken if n is the root of the tree
-	void InternalInsertAtRoot(Node<Element> *n)
+	// Recomputes the augmented data of n and of its ancestors
+	inline void UpdatePath(Node<Element> *n)
 	{
+		if (!Augmentation::kEnabled)
+			return;
+		for (; n; n = n->parent_)
+			Update(n);
+	}
+
+	void DestroyNode(Node<Element> *n)
+	{
+		n->Data().~Element();
+		pool_->Delete(n);
+	}
+
+	// The rotations and the fix-ups work on the subtree whose root is 'root', which is root_ or a subtree detached by the
+	// join-based operations
+	void RotateLeft(Node<Element> *n, Node<Element> *&root)
+	{
+		Node<Element> *saved_right = n->right_;
+		n->right_ = saved_right->left_;
+		if (n->right_ != nil_)
+			n->right_->parent_ = n;
+		saved_right->parent_ = n->parent_;
 		if (!n->parent_)
-			n->PaintInBlack();
+			root = saved_right;
+		else if (n->parent_->left_ == n)
+			n->parent_->left_ = saved_right;
 		else
-			InternalInsertBlackParent(n);
+			n->parent_->right_ = saved_right;
+		saved_right->left_ = n;
+		n->parent_ = saved_right;
+		// The subtree of saved_right now holds the elements n held
+		if (Augmentation::kEnabled)
+		{
+			Update(n);
+			Update(saved_right);
+		}
 	}
 
-	// Action taken if n's parent is black
-	void InternalInsertBlackParent(Node<Element> *n)
+	void RotateRight(Node<Element> *n, Node<Element> *&root)
 	{
-		if (n->parent_->IsBlack())
-			// Properties 4 and 5 still hold
-			return;
+		Node<Element> *saved_left = n->left_;
+		n->left_ = saved_left->right_;
+		if (n->left_ != nil_)
+			n->left_->parent_ = n;
+		saved_left->parent_ = n->parent_;
+		if (!n->parent_)
+			root = saved_left;
+		else if (n->parent_->left_ == n)
+			n->parent_->left_ = saved_left;
 		else
-			InternalInsertRedParentAndUncle(n);
+			n->parent_->right_ = saved_left;
+		saved_left->right_ = n;
+		n->parent_ = saved_left;
+		if (Augmentation::kEnabled)
+		{
+			Update(n);
+			Update(saved_left);
+		}
 	}
 
-	// Action taken if both n's parent and uncle are red
-	void InternalInsertRedParentAndUncle(Node<Element> *n)
+	// Restores properties 2 and 4 after the insertion of the red node n. Non recursive.
+	void InsertFixUp(Node<Element> *n, Node<Element> *&root)
 	{
-		Node<Element> *uncle = FindUncle(n);
-		if (uncle)
+		// The root is black, so a red parent always has a parent
+		while (n->parent_ && n->parent_->IsRed())
 		{
+			Node<Element> *parent = n->parent_;
+			Node<Element> *grand_parent = parent->parent_;
+			bool parent_is_left = (grand_parent->left_ == parent);
+			Node<Element> *uncle = (parent_is_left ? grand_parent->right_ : grand_parent->left_);
 			if (uncle->IsRed())
 			{
-				// Paint the grand parent in red and repaint the parent and uncle in black
-				uncle->parent_->PaintInRed();
-				n->parent_->PaintInBlack();
+				// Paint the grand parent in red and repaint the parent and uncle in black. However, the grand parent may now
+				// violate property 2 or 4 (the grand grand parent may be red)
+				parent->PaintInBlack();
 				uncle->PaintInBlack();
-				// However, the grand parent may now violate property 2 or 4 (the grand grand parent may be red)
-				InternalInsertAtRoot(uncle->parent_);
+				grand_parent->PaintInRed();
+				n = grand_parent;
+			}
+			else
+			{
+				// If n is the inner grand child, rotate parent so that n becomes the outer one
+				if (parent_is_left && parent->right_ == n)
+				{
+					RotateLeft(parent, root);
+					std::swap(n, parent);
+				}
+				else if (!parent_is_left && parent->left_ == n)
+				{
+					RotateRight(parent, root);
+					std::swap(n, parent);
+				}
+				parent->PaintInBlack();
+				grand_parent->PaintInRed();
+				if (parent_is_left)
+					RotateRight(grand_parent, root);
+				else
+					RotateLeft(grand_parent, root);
+			}
+		}
+		root->PaintInBlack();
+	}
+
+	// Replaces the subtree rooted at n with the subtree rooted at replacement, which may be the sentinel
+	void Transplant(Node<Element> *n, Node<Element> *replacement)
+	{
+		if (!n->parent_)
+			root_ = replacement;
+		else if (n->parent_->left_ == n)
+			n->parent_->left_ = replacement;
+		else
+			n->parent_->right_ = replacement;
+		if (replacement != nil_)
+			replacement->parent_ = n->parent_;
+	}
+
+	// n took the place of a removed black node below 'parent' and carries an extra black. Moves the extra black up the tree
+	// until it can be discarded on a red node, or fixes it with at most three rotations. n may be the sentinel, hence the
+	// explicit parent. Non recursive.
+	void DeleteFixUp(Node<Element> *n, Node<Element> *parent)
+	{
+		while (n != root_ && n->IsBlack())
+		{
+			if (parent->left_ == n)
+			{
+				Node<Element> *sibling = parent->right_;
+				if (sibling->IsRed())
+				{
+					sibling->PaintInBlack();
+					parent->PaintInRed();
+					RotateLeft(parent, root_);
+					sibling = parent->right_;
+				}
+				if (sibling->left_->IsBlack() && sibling->right_->IsBlack())
+				{
+					sibling->PaintInRed();
+					n = parent;
+					parent = n->parent_;
+				}
+				else
+				{
+					if (sibling->right_->IsBlack())
+					{
+						sibling->left_->PaintInBlack();
+						sibling->PaintInRed();
+						RotateRight(sibling, root_);
+						sibling = parent->right_;
+					}
+					sibling->color_ = parent->color_;
+					parent->PaintInBlack();
+					sibling->right_->PaintInBlack();
+					RotateLeft(parent, root_);
+					n = root_;
+				}
 			}
 			else
-				InternalInsertRedParentAndBlackUncle(n);
+			{
+				Node<Element> *sibling = parent->left_;
+				if (sibling->IsRed())
+				{
+					sibling->PaintInBlack();
+					parent->PaintInRed();
+					RotateRight(parent, root_);
+					sibling = parent->left_;
+				}
+				if (sibling->left_->IsBlack() && sibling->right_->IsBlack())
+				{
+					sibling->PaintInRed();
+					n = parent;
+					parent = n->parent_;
+				}
+				else
+				{
+					if (sibling->left_->IsBlack())
+					{
+						sibling->right_->PaintInBlack();
+						sibling->PaintInRed();
+						RotateLeft(sibling, root_);
+						sibling = parent->left_;
+					}
+					sibling->color_ = parent->color_;
+					parent->PaintInBlack();
+					sibling->left_->PaintInBlack();
+					RotateRight(parent, root_);
+					n = root_;
+				}
+			}
 		}
+		if (n != nil_)
+			n->PaintInBlack();
 	}
 
-	// Action taken if n's parent is red but n's uncle is black
-	void InternalInsertRedParentAndBlackUncle(Node<Element> *n)
+	// Unlinks the node 'n' as for a regular binary tree, then restores the red-black properties if a black node was removed
+	// from a path. When n has two children, it is replaced by its successor node, so that no element is moved and the other
+	// nodes stay valid.
+	void InternalDelete(Node<Element> *n)
 	{
-		Node<Element> *parent = n->parent_;
-		Node<Element> *grand_parent = parent->parent_;
-		// If n is the right child of parent and parent in turn is the left child of its parent grand_parent, rotate parent left
-		// then deal with the former parent
-		if (parent->right_ == n && grand_parent->left_ == parent)
+		Node<Element> *removed = n;
+		typename Node<Element>::Color removed_color = removed->color();
+		Node<Element> *child;
+		Node<Element> *child_parent = n->parent_;
+		if (n->left_ == nil_)
 		{
-			parent->RotateLeft();
-			if (parent == root_)
-				root_ = n;
-			InternalInsertRedParentAndBlackUncleLast(parent);
+			child = n->right_;
+			Transplant(n, child);
 		}
-		else if (parent->left_ == n && grand_parent->right_ == parent)
+		else if (n->right_ == nil_)
 		{
-			parent->RotateRight();
-			if (parent == root_)
-				root_ = n;
-			InternalInsertRedParentAndBlackUncleLast(parent);
+			child = n->left_;
+			Transplant(n, child);
 		}
 		else
-			InternalInsertRedParentAndBlackUncleLast(n);
+		{
+			removed = GetMin(n->right_);
+			removed_color = removed->color();
+			child = removed->right_;
+			child_parent = removed->parent_;
+			if (removed->parent_ == n)
+				child_parent = removed;
+			else
+			{
+				Transplant(removed, child);
+				removed->right_ = n->right_;
+				removed->right_->parent_ = removed;
+			}
+			Transplant(n, removed);
+			removed->left_ = n->left_;
+			removed->left_->parent_ = removed;
+			removed->color_ = n->color_;
+		}
+		// child_parent is the lowest node whose subtree lost an element
+		UpdatePath(child_parent);
+		if (removed_color == Node<Element>::kBlack)
+			DeleteFixUp(child, child_parent);
 	}
 
-	void InternalInsertRedParentAndBlackUncleLast(Node<Element> *n)
+	// Join-based operations. They work on detached subtrees whose roots have no parent, and only relink nodes (no
+	// allocation), so that disjoint subtrees can be processed by different threads.
+
+	inline void Detach(Node<Element> *n)
 	{
-		Node<Element> *parent = n->parent_;
-		Node<Element> *grand_parent = parent->parent_;
-		parent->PaintInBlack();
-		grand_parent->PaintInRed();
-		if (parent->right_ == n)
-			grand_parent->RotateLeft();
-		else if (parent->left_ == n)
-			grand_parent->RotateRight();
-		// Fix the root node
-		if (root_ == grand_parent)
-			root_ = grand_parent->parent_;
+		if (n != nil_)
+			n->parent_ = nullptr;
 	}
 
-	// Delete the node 'n' as for a regular binary tree. The difference is the way the deletion of nodes with at most 1 non leaf child is done.
-	void InternalDelete(Node<Element> *n)
+	inline void Link(Node<Element> *n, Node<Element> *left, Node<Element> *right)
 	{
-		Node<Element> *n_parent = n->parent();
-		// Case 1: n has 2 children
-		// Replace n with the minimum element from the subtree whose root is n->right()
-		// The color of the nodes are left unchanged.
-		if (!n->left()->IsLeaf() && !n->right()->IsLeaf())
-		{
-			Node<Element> *min = GetMin(n->right());	// min can't be nullptr
-			Node<Element>::Color saved_n_color = n->color();
-			Node<Element> *saved_min_parent = min->parent();
-			Node<Element> *saved_min_left = min->left();
-			Node<Element> *saved_min_right = min->right();
-
-			// Swap min with n
-			min->parent_ = n_parent;
-			min->left_ = n->left();
-			min->right_ = n->right();
-
-			// Update min's children
-			if (min->left())
-				min->left()->parent_ = min;
-			if (min->right())
-				min->right()->parent_ = min;
-
-			if (n_parent)
-			{
-				if (n_parent->left() == n)
-					n_parent->left_ = min;
-				else
-					n_parent->right_ = min;
-			}
-			// n is the root
-			else
-				root_ = min;
-
-			n->parent_ = saved_min_parent;
-			n->left_ = saved_min_left;
-			n->right_ = saved_min_right;
-			// Update n's children
-			if (n->left())
-				n->left()->parent_ = n;
-			if (n->right())
-				n->right()->parent_ = n;
-
-			if (saved_min_parent->left() == min)
-				saved_min_parent->left_ = n;
-			else
-				saved_min_parent->right_ = n;
+		n->left_ = left;
+		n->right_ = right;
+		if (left != nil_)
+			left->parent_ = n;
+		if (right != nil_)
+			right->parent_ = n;
+	}
 
-			n->color_ = min->color();
-			min->color_ = saved_n_color;
+	// Number of black nodes on the paths from n to its leaves
+	size_t BlackHeight(const Node<Element> *n)	const
+	{
+		size_t height = 0;
+		for (; n != nil_; n = n->left_)
+			height += n->IsBlack();
+		return height;
+	}
+
+	size_t SubtreeSize(const Node<Element> *n, std::true_type)	const	{ return n->size_; }
 
-			// After swapping n with min, at most one child of n is a non leaf node
+	size_t SubtreeSize(const Node<Element> *n, std::false_type)	const
+	{
+		size_t size = 0;
+		std::vector<const Node<Element> *> stack;
+		if (n != nil_)
+			stack.push_back(n);
+		while (!stack.empty())
+		{
+			n = stack.back();
+			stack.pop_back();
+			++size;
+			if (n->left_ != nil_)
+				stack.push_back(n->left_);
+			if (n->right_ != nil_)
+				stack.push_back(n->right_);
 		}
-		// Case 2: n has at most one non leaf node
-		InternalDeleteOneOrNoNonLeafChild(n);
+		return size;
 	}
 
-	// n has at most one non leaf node
-	void InternalDeleteOneOrNoNonLeafChild(Node<Element> *n)
+	// Builds a perfectly balanced subtree from the 'size' next elements of it in increasing order. The nodes at depth
+	// red_depth, the last and incomplete level, are red so that every path holds red_depth black nodes. O(size)
+	template<typename U>
+	Node<Element> *BuildSubtree(U &it, size_t size, size_t depth, size_t red_depth)
 	{
-		Node<Element> *n_parent = n->parent();
-		if (n_parent)
+		if (size == 0)
+			return nil_;
+		size_t left_size = (size - 1) / 2;
+		Node<Element> *left = BuildSubtree(it, left_size, depth + 1, red_depth);
+		Node<Element> *n = pool_->New(*it, nullptr, nil_);
+		++it;
+		Node<Element> *right = BuildSubtree(it, size - 1 - left_size, depth + 1, red_depth);
+		Link(n, left, right);
+		n->color_ = (depth >= red_depth ? Node<Element>::kRed : Node<Element>::kBlack);
+		if (Augmentation::kEnabled)
+			Update(n);
+		return n;
+	}
+
+	template<typename U>
+	Node<Element> *BuildSubtree(U it_begin, size_t size)
+	{
+		size_t red_depth = 0;
+		while ((size_t(2) << red_depth) <= size + 1)
+			++red_depth;
+		return BuildSubtree(it_begin, size, 0, red_depth);
+	}
+
+	// Returns the root of a valid red-black tree made of l, k and r, where the elements of l are <= k and those of r are >= k.
+	// k is inserted along the right spine of l (or the left spine of r) at the first black node with the black height of
+	// the other tree, then the red-red violation it may cause is fixed as for an insertion. O(|bh(l) - bh(r)|)
+	Node<Element> *JoinNodes(Node<Element> *l, Node<Element> *k, Node<Element> *r)
+	{
+		if (l != nil_)
+			l->PaintInBlack();
+		if (r != nil_)
+			r->PaintInBlack();
+		size_t l_height = BlackHeight(l);
+		size_t r_height = BlackHeight(r);
+		k->parent_ = nullptr;
+		if (l_height == r_height)
 		{
-			Node<Element> *child = (n->right()->IsLeaf() ? n->left() : n->right());
-			if (child->IsLeaf())	// n has two leaf nodes
-				child = new Node<Element>(n_parent);
-			child->parent_ = n_parent;
-			// Replace n with child
-			if (n_parent->left() == n)
-				n_parent->left_ = child;
-			else
-				n_parent->right_ = child;
+			Link(k, l, r);
+			k->PaintInBlack();
+			if (Augmentation::kEnabled)
+				Update(k);
+			return k;
+		}
 
-			if (n->IsBlack())
+		Node<Element> *root;
+		Node<Element> *parent = nullptr;
+		if (l_height > r_height)
+		{
+			root = l;
+			Node<Element> *n = l;
+			size_t height = l_height;
+			while (n->IsRed() || height > r_height)
 			{
-				if (child->IsRed())
-					child->PaintInBlack();
-				else
-					InternalDeleteRoot(child);
+				if (n->IsBlack())
+					--height;
+				parent = n;
+				n = n->right_;
 			}
+			Link(k, n, r);
+			parent->right_ = k;
 		}
 		else
-			root_ = nullptr;
-	}
-
-	// n is black (see InternalDeleteOneOrNoNonLeafChild)
-	void InternalDeleteRoot(Node<Element> *n)
-	{
-		if (n->parent())
-			InternalDeleteRedSibling(n);
-		else
-			root_ = n;
+		{
+			root = r;
+			Node<Element> *n = r;
+			size_t height = r_height;
+			while (n->IsRed() || height > l_height)
+			{
+				if (n->IsBlack())
+					--height;
+				parent = n;
+				n = n->left_;
+			}
+			Link(k, l, n);
+			parent->left_ = k;
+		}
+		k->parent_ = parent;
+		k->PaintInRed();
+		UpdatePath(k);
+		InsertFixUp(k, root);
+		return root;
 	}
 
-	void InternalDeleteRedSibling(Node<Element> *n)
+	// Splits the subtree n into l, the elements smaller than e, and r, the elements larger than or equal to e. O(log n)
+	void SplitNodes(Node<Element> *n, const Element &e, Node<Element> *&l, Node<Element> *&r)
 	{
-		Node<Element> *sibling = FindSibling(n);
-		// sibling can't be nullptr, for n can't be the root node (see InternalDeleteRoot)
-		if (sibling->IsRed())
+		if (n == nil_)
 		{
-			Node<Element> *n_parent = n->parent();
-			sibling->PaintInBlack();
-			n_parent->PaintInBlack();
-			if (n_parent->left() == n)
-				n_parent->RotateLeft();
-			else
-				n_parent->RotateRight();
+			l = r = nil_;
+			return;
+		}
+		Node<Element> *left = n->left_;
+		Node<Element> *right = n->right_;
+		Detach(left);
+		Detach(right);
+		if (n->data() < e)
+		{
+			Node<Element> *right_left;
+			SplitNodes(right, e, right_left, r);
+			l = JoinNodes(left, n, right_left);
 		}
 		else
-			InternalDeleteBlackSibling(n);
+		{
+			Node<Element> *left_right;
+			SplitNodes(left, e, l, left_right);
+			r = JoinNodes(left_right, n, right);
+		}
 	}
 
-	void InternalDeleteBlackSibling(Node<Element> *n)
+	// Removes the maximum node of the subtree n, returned in max, and returns the root of the remaining subtree. O(log n)
+	Node<Element> *SplitLast(Node<Element> *n, Node<Element> *&max)
 	{
-		Node<Element> *sibling = FindSibling(n);
-		Node<Element> *n_parent = n->parent();
-		if (n_parent->IsBlack() && sibling->IsBlack() && sibling->left()->IsBlack() && sibling->right()->IsBlack())
+		Node<Element> *left = n->left_;
+		Node<Element> *right = n->right_;
+		Detach(left);
+		Detach(right);
+		if (right == nil_)
 		{
-			sibling->PaintInRed();
-			InternalDeleteRoot(n_parent);
+			max = n;
+			return left;
 		}
-		else
-			InternalDeleteBlackSiblingRedParent(n);
+		return JoinNodes(left, n, SplitLast(right, max));
 	}
 
-	void InternalDeleteBlackSiblingRedParent(Node<Element> *n)
+	// Returns the union of the subtrees a and b: b is split around the root of a, the two halves are merged recursively with
+	// the children of a and the results are joined with the root of a. O(m log(n/m + 1)) work for sizes m <= n.
+	Node<Element> *UnionNodes(Node<Element> *a, Node<Element> *b, unsigned int threads)
 	{
-		Node<Element> *sibling = FindSibling(n);
-		Node<Element> *n_parent = n->parent();
-		if (n_parent->IsRed() && sibling->IsBlack() && sibling->left()->IsBlack() && sibling->right()->IsBlack())
+		if (a == nil_)
+			return b;
+		if (b == nil_)
+			return a;
+		Node<Element> *a_left = a->left_;
+		Node<Element> *a_right = a->right_;
+		Detach(a_left);
+		Detach(a_right);
+		Node<Element> *b_left, *b_right;
+		SplitNodes(b, a->data(), b_left, b_right);
+		Node<Element> *left, *right;
+		if (threads > 1)
 		{
-			sibling->PaintInRed();
-			n_parent->PaintInBlack();
+#pragma omp parallel sections num_threads(2)
+			{
+#pragma omp section
+				{
+					left = UnionNodes(a_left, b_left, threads >> 1);
+				}
+#pragma omp section
+				{
+					right = UnionNodes(a_right, b_right, threads - (threads >> 1));
+				}
+			}
 		}
 		else
-			InternalDeleteBlackSiblingRedLeftSiblingChild(n);
+		{
+			left = UnionNodes(a_left, b_left, 1);
+			right = UnionNodes(a_right, b_right, 1);
+		}
+		return JoinNodes(left, a, right);
 	}
 
-	void InternalDeleteBlackSiblingRedLeftSiblingChild(Node<Element> *n)
+	// Takes the nodes of 'other', which becomes empty, and returns their subtree. When the trees do not share their pool, the
+	// elements are moved into new nodes of this tree's pool in O(m) time.
+	Node<Element> *AdoptNodes(RBTree &other)
 	{
-		Node<Element> *sibling = FindSibling(n);
-		Node<Element> *n_parent = n->parent();
-		if (sibling->IsBlack())
+		Node<Element> *n = other.root_;
+		if (other.pool_ != pool_)
 		{
-			if (n_parent->left() == n && sibling->left()->IsRed() && sibling->right()->IsBlack())
-			{
-				sibling->left()->PaintInBlack();
-				sibling->PaintInRed();
-				sibling->RotateRight();
-			}
-			else if (n_parent->right() == n && sibling->right()->IsRed() && sibling->left()->IsBlack())
+			std::vector<Element> elements;
+			elements.reserve(other.size_);
+			std::vector<Node<Element> *> stack;
+			for (Node<Element> *current = other.root_; current != nil_ || !stack.empty();)
 			{
-				sibling->right()->PaintInBlack();
-				sibling->PaintInRed();
-				sibling->RotateLeft();
+				for (; current != nil_; current = current->left_)
+					stack.push_back(current);
+				current = stack.back();
+				stack.pop_back();
+				elements.push_back(std::move(current->Data()));
+				current = current->right_;
 			}
+			other.Clear();
+			return BuildSubtree(std::make_move_iterator(elements.begin()), elements.size());
 		}
-		InternalDeleteBlackSiblingRedRightSiblingChild(n);
+		other.root_ = nil_;
+		other.size_ = 0;
+		Detach(n);
+		return n;
 	}
 
-	void InternalDeleteBlackSiblingRedRightSiblingChild(Node<Element> *n)
+	inline void SetRoot(Node<Element> *n)
 	{
-		Node<Element> *sibling = FindSibling(n);
-		Node<Element> *n_parent = n->parent();
-		if (n_parent->left() == n)
+		root_ = n;
+		if (root_ != nil_)
 		{
-			sibling->right()->PaintInBlack();
-			n_parent->RotateLeft();
-		}
-		else
-		{
-			sibling->left()->PaintInBlack();
-			n_parent->RotateRight();
+			root_->parent_ = nullptr;
+			root_->PaintInBlack();
 		}
 	}
 
-public:
-	// O(log n) worst case time complexity
-	void Insert(const Element &e)
+	template<typename U>
+	void InternalInsert(U &&e)
 	{
-		Node<Element> **n = &root_;
-		// n's parent
-		Node<Element> *parent = *n;
-		// Go down the tree until we find an empty node while satisfying the following restriction:
+		Node<Element> *parent = nullptr;
+		Node<Element> *n = root_;
+		// Go down the tree until we find a leaf while satisfying the following restriction:
 		// - Any node value is larger than any node value in that node's left subtree
 		// - Any node value is smaller than any node value in that node's right subtree
-		while (*n)
+		bool left = false;
+		while (n != nil_)
 		{
-			parent = *n;
-			if (e < (*n)->data())
-				n = &((*n)->left_);
-			else
-				n = &((*n)->right_);
-			if ((*n)->IsLeaf())
-				break;
+			parent = n;
+			left = (e < n->data());
+			n = (left ? n->left_ : n->right_);
 		}
-		delete (*n);
-		*n = new Node<Element>(e, parent);
-		(*n)->PaintInRed();
-		
-		InternalInsertAtRoot(*n);
+		n = pool_->New(std::forward<U>(e), parent, nil_);
+		if (!parent)
+			root_ = n;
+		else if (left)
+			parent->left_ = n;
+		else
+			parent->right_ = n;
+		++size_;
+		UpdatePath(n);
+		InsertFixUp(n, root_);
 	}
 
-	// O(log n) worst case time complexity
-	void Insert(const Element &&e)
+public:
+	// Bidirectional iterator on the elements in increasing order. Elements are immutable, as in std::set. Iterators stay
+	// valid until their node is deleted.
+	class Iterator
 	{
-		Node<Element> **n = &root_;
-		Node<Element> *parent = *n;
-		// Go down the tree until we find an empty node while satisfying the following restriction:
-		// - Any node value is larger than any node value in that node's left subtree
-		// - Any node value is smaller than any node value in that node's right subtree
-		while (*n)
+		friend class RBTree;
+
+	private:
+		const Node<Element> *node_ = nullptr;	// nullptr for end()
+		const RBTree *tree_ = nullptr;
+
+		Iterator(const Node<Element> *node, const RBTree *tree) : node_(node), tree_(tree)	{}
+
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef Element value_type;
+		typedef ptrdiff_t difference_type;
+		typedef const Element *pointer;
+		typedef const Element &reference;
+
+		Iterator()	{}
+
+		inline reference operator*()	const	{ return node_->data(); }
+		inline pointer operator->()	const	{ return &node_->data(); }
+		inline bool operator==(const Iterator &it)	const	{ return node_ == it.node_; }
+		inline bool operator!=(const Iterator &it)	const	{ return node_ != it.node_; }
+		// Node of the element, to be passed to RBTree::Delete
+		inline Node<Element> *node()	const	{ return const_cast<Node<Element> *>(node_); }
+
+		// Amortized constant time
+		Iterator &operator++()
 		{
-			parent = *n;
-			if (e < (*n)->data())
-				n = &((*n)->left_);
-			else
-				n = &((*n)->right_);
-			if ((*n)->IsLeaf())
-				break;
+			node_ = tree_->Successor(node_);
+			return *this;
 		}
-		delete (*n);
-		*n = new Node<Element>(std::move(e), parent);
-		(*n)->PaintInRed();
 
-		InternalInsertAtRoot(*n);
+		Iterator &operator--()
+		{
+			node_ = (node_ ? tree_->Predecessor(node_) : tree_->GetMax(tree_->root_));
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it(*this);
+			++*this;
+			return it;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it(*this);
+			--*this;
+			return it;
+		}
+	};
+	typedef Iterator iterator;
+	typedef Iterator const_iterator;
+
+	RBTree()	{}
+	~RBTree()	{ Clear(); }
+
+	RBTree(const RBTree &) = delete;
+	RBTree &operator=(const RBTree &) = delete;
+
+	// O(log n) worst case time complexity
+	void Insert(const Element &e)
+	{
+		InternalInsert(e);
+	}
+
+	// O(log n) worst case time complexity
+	void Insert(const Element &&e)
+	{
+		InternalInsert(std::move(e));
 	}
 
 	// Returns the node whose value is 'e', or nullptr if the node could not be found. log(n) time complexity.
 	Node<Element> *Find(const Element &e)
 	{
-		if (!root_)
-			return nullptr;
 		Node <Element> *n = root_;
-		while (e != n->data())
+		while (n != nil_ && e != n->data())
 		{
 			if (e < n->data())
 				n = n->left();
 			else
 				n = n->right();
-			if (!n)
-				break;
 		}
-		if (n)
-		{
-			if (n->IsLeaf())
-				return nullptr;
-		}
-		return n;
+		return (n != nil_ ? n : nullptr);
 	}
 
+	// O(log n) worst case time complexity
 	void Delete(Node<Element> *n)
 	{
 		InternalDelete(n);
-		delete n;
+		DestroyNode(n);
+		--size_;
+	}
+
+	// Replaces the elements of the tree with the elements between it_begin and it_end-1 inclusive, which must be sorted.
+	// The tree is built in O(n) time, without any comparison nor rotation.
+	template<typename U>
+	void BuildFromSorted(U it_begin, U it_end)
+	{
+		Clear();
+		size_ = size_t(std::distance(it_begin, it_end));
+		root_ = BuildSubtree(it_begin, size_);
+	}
+
+	// Inserts the elements between it_begin and it_end-1 inclusive, which must be sorted: they are built into a tree in
+	// O(m) time, which is merged with this tree by Union.
+	template<typename U>
+	void InsertSorted(U it_begin, U it_end, unsigned int threads = 1)
+	{
+		size_t size = size_t(std::distance(it_begin, it_end));
+		Node<Element> *batch = BuildSubtree(it_begin, size);
+		size_ += size;
+		SetRoot(UnionNodes(root_, batch, threads));
+	}
+
+	// Moves all the elements of 'other' into this tree and leaves it empty. O(m log(n/m + 1)) work for sizes m <= n, the
+	// recursion being divided among up to 'threads' threads.
+	void Union(RBTree &other, unsigned int threads = 1)
+	{
+		if (&other == this)
+			return;
+		size_t size = other.size_;
+		Node<Element> *b = AdoptNodes(other);
+		size_ += size;
+		SetRoot(UnionNodes(root_, b, threads));
+	}
+
+	// Moves the elements larger than or equal to e to 'right', whose elements are deleted first. Both trees share their pool
+	// afterwards. O(log n), plus the time to count the elements of right when the tree is not augmented with subtree sizes.
+	void Split(const Element &e, RBTree &right)
+	{
+		if (&right == this)
+			return;
+		right.Clear();
+		right.pool_ = pool_;
+		Node<Element> *l, *r;
+		SplitNodes(root_, e, l, r);
+		SetRoot(l);
+		right.SetRoot(r);
+		right.size_ = (r != nil_ ? SubtreeSize(r, std::integral_constant<bool, Augmentation::kEnabled>()) : 0);
+		size_ -= right.size_;
+	}
+
+	// Moves the elements of 'right', which must be larger than or equal to the elements of this tree, to this tree and leaves
+	// it empty. O(log n) when both trees share their pool, e.g. after Split, O(m) for the m elements of right otherwise.
+	void Join(RBTree &right)
+	{
+		if (&right == this || right.root_ == nil_)
+			return;
+		size_t size = right.size_;
+		Node<Element> *r = AdoptNodes(right);
+		size_ += size;
+		if (root_ == nil_)
+		{
+			SetRoot(r);
+			return;
+		}
+		Node<Element> *max;
+		Node<Element> *l = SplitLast(root_, max);
+		SetRoot(JoinNodes(l, max, r));
+	}
+
+	// Deletes all the nodes. The memory of the pool is released unless the pool is shared with other trees, in which case
+	// the nodes are given back to it.
+	void Clear()
+	{
+		bool shared_pool = (pool_.use_count() > 1);
+		if ((shared_pool || !std::is_trivially_destructible<Element>::value || !std::is_trivially_destructible<NodeData>::value) && root_ != nil_)
+		{
+			std::vector<Node<Element> *> stack(1, root_);
+			while (!stack.empty())
+			{
+				Node<Element> *n = stack.back();
+				stack.pop_back();
+				if (n->left_ != nil_)
+					stack.push_back(n->left_);
+				if (n->right_ != nil_)
+					stack.push_back(n->right_);
+				n->Data().~Element();
+				n->~Node();
+				if (shared_pool)
+					pool_->Deallocate(n);
+			}
+		}
+		if (!shared_pool)
+			pool_->Clear();
+		root_ = nil_;
+		size_ = 0;
+	}
+
+	inline Iterator begin()	const	{ return Iterator(GetMin(root_), this); }
+	inline Iterator end()	const	{ return Iterator(nullptr, this); }
+
+	// Returns an iterator on the first element larger than or equal to e, or end(). O(log n)
+	Iterator LowerBound(const Element &e)	const
+	{
+		const Node<Element> *bound = nullptr;
+		for (const Node<Element> *n = root_; n != nil_;)
+		{
+			if (n->data() < e)
+				n = n->right_;
+			else
+			{
+				bound = n;
+				n = n->left_;
+			}
+		}
+		return Iterator(bound, this);
+	}
+
+	// Returns an iterator on the first element larger than e, or end(). O(log n)
+	Iterator UpperBound(const Element &e)	const
+	{
+		const Node<Element> *bound = nullptr;
+		for (const Node<Element> *n = root_; n != nil_;)
+		{
+			if (e < n->data())
+			{
+				bound = n;
+				n = n->left_;
+			}
+			else
+				n = n->right_;
+		}
+		return Iterator(bound, this);
+	}
+
+	// Calls fn(e) for each element e such that lo <= e <= hi, in increasing order, without copying. Only the nodes on the
+	// path to lo and the nodes of the range are visited: O(log n + k) for k elements in the range.
+	template<typename F>
+	void ForEachInRange(const Element &lo, const Element &hi, F fn)	const
+	{
+		for (Iterator it = LowerBound(lo); it.node_ && !(hi < *it); ++it)
+			fn(*it);
+	}
+
+	// Returns the node following n in increasing order, or nullptr if n is the maximum. O(log n) worst case, amortized
+	// constant time over an in-order walk.
+	const Node<Element> *Successor(const Node<Element> *n)	const
+	{
+		if (n->right_ != nil_)
+		{
+			n = n->right_;
+			while (n->left_ != nil_)
+				n = n->left_;
+			return n;
+		}
+		while (n->parent_ && n->parent_->right_ == n)
+			n = n->parent_;
+		return n->parent_;
+	}
+
+	// Returns the node preceding n in increasing order, or nullptr if n is the minimum
+	const Node<Element> *Predecessor(const Node<Element> *n)	const
+	{
+		if (n->left_ != nil_)
+		{
+			n = n->left_;
+			while (n->right_ != nil_)
+				n = n->right_;
+			return n;
+		}
+		while (n->parent_ && n->parent_->left_ == n)
+			n = n->parent_;
+		return n->parent_;
 	}
 
 	// Returns the node whose value is minimum in the subtree whose 'root' is passed as argument
-	Node<Element> *GetMin(Node<Element> *root)
+	Node<Element> *GetMin(Node<Element> *root)	const
 	{
-		if (!root)
+		if (!root || root == nil_)
 			return nullptr;
 		Node<Element> *n = root;
-		while (n->left())
+		while (n->left() != nil_)
 			n = n->left();
-		// n is a leaf node.The actual minimum value is its parent
-		return n->parent();
+		return n;
 	}
 
 	// Returns the node whose value is maximum in the subtree whose 'root' is passed as argument
-	Node<Element> *GetMax(Node<Element> *root)
+	Node<Element> *GetMax(Node<Element> *root)	const
 	{
-		if (!root)
+		if (!root || root == nil_)
 			return nullptr;
 		Node<Element> *n = root;
-		while (n->right())
+		while (n->right() != nil_)
 			n = n->right();
-		// n is a leaf node.The actual maximum value is its parent
-		return n->parent();
+		return n;
+	}
+
+	// Returns the number of elements smaller than e. Requires an order statistics augmentation. O(log n)
+	size_t Rank(const Element &e)	const
+	{
+		static_assert(Augmentation::kEnabled, "RBTree::Rank requires RBTreeOrderStatistics or RBTreeAggregate");
+		size_t rank = 0;
+		const Node<Element> *n = root_;
+		while (n != nil_)
+		{
+			if (n->data() < e)
+			{
+				rank += n->left_->size_ + 1;
+				n = n->right_;
+			}
+			else
+				n = n->left_;
+		}
+		return rank;
+	}
+
+	// Returns the node holding the k-th smallest element (k starting at 0), or nullptr if k >= Size(). Requires an order
+	// statistics augmentation. O(log n)
+	Node<Element> *Select(size_t k)
+	{
+		static_assert(Augmentation::kEnabled, "RBTree::Select requires RBTreeOrderStatistics or RBTreeAggregate");
+		if (k >= size_)
+			return nullptr;
+		Node<Element> *n = root_;
+		while (true)
+		{
+			size_t left_size = n->left_->size_;
+			if (k == left_size)
+				return n;
+			if (k < left_size)
+				n = n->left_;
+			else
+			{
+				k -= left_size + 1;
+				n = n->right_;
+			}
+		}
+	}
+
+	// Returns the aggregate, in increasing order, of the elements e such that lo <= e <= hi. Requires RBTreeAggregate.
+	// The search paths of lo and hi are walked from the node where they split, combining the aggregates of the subtrees
+	// hanging between them: O(log n).
+	template<typename A = Augmentation>
+	typename A::Monoid::Value RangeAggregate(const Element &lo, const Element &hi)	const
+	{
+		typedef typename A::Monoid Monoid;
+		const Node<Element> *split = root_;
+		while (split != nil_)
+		{
+			if (split->data() < lo)
+				split = split->right_;
+			else if (hi < split->data())
+				split = split->left_;
+			else
+				break;
+		}
+		if (split == nil_)
+			return Monoid::Identity();
+
+		// Elements >= lo of the left subtree. Nodes are found in decreasing order.
+		typename Monoid::Value left = Monoid::Identity();
+		for (const Node<Element> *n = split->left_; n != nil_;)
+		{
+			if (n->data() < lo)
+				n = n->right_;
+			else
+			{
+				left = Monoid::Combine(Monoid::Combine(Monoid::Lift(n->data()), n->right_->aggregate_), left);
+				n = n->left_;
+			}
+		}
+		// Elements <= hi of the right subtree. Nodes are found in increasing order.
+		typename Monoid::Value right = Monoid::Identity();
+		for (const Node<Element> *n = split->right_; n != nil_;)
+		{
+			if (hi < n->data())
+				n = n->left_;
+			else
+			{
+				right = Monoid::Combine(right, Monoid::Combine(n->left_->aggregate_, Monoid::Lift(n->data())));
+				n = n->right_;
+			}
+		}
+		return Monoid::Combine(Monoid::Combine(left, Monoid::Lift(split->data())), right);
 	}
 
-	inline Node<Element> *root()	{ return root_; }
+	// Returns nullptr if the tree is empty
+	inline Node<Element> *root()	{ return (root_ != nil_ ? root_ : nullptr); }
+	inline size_t Size()	const	{ return size_; }
+	inline bool IsEmpty()	const	{ return size_ == 0; }
+	// Memory used by the nodes
+	inline size_t AllocatedBytes()	const	{ return pool_->AllocatedBytes(); }
 };
 
-#endif
\ No newline at end of file
+#endif
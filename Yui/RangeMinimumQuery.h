@@ -4,59 +4,192 @@
 // Implementation of range minimum query : generalized case with precalculation in O(n*log(n)) time and O(1) query time
 // Special case where the input array is such that the difference between 2 consecutive elements is +1 or -1. In this case,
 // precalculation in O(n) time and O(1) query time. This can be used to solve the lowest common ancestor problem efficiently.
+// Succinct case storing about 3 bits per element instead of the O(n*log(n)) indices, with precalculation in O(n) time and
+// O(1) query time.
+// Dynamic case supporting updates of the elements in O(log(n)) time, with queries in O(log(n)) time.
+#include "SortingNetwork.h"
+
+#include <algorithm>
+#include <limits>
 #include <vector>
+#include <assert.h>
 #include <math.h>
 #include <limits.h>
+#include <string.h>
+#include <utility>
+#include <stdint.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define __RMQ_PREFETCH(address)	_mm_prefetch(reinterpret_cast<const char *>(address), _MM_HINT_T0)
+#else
+#define __RMQ_PREFETCH(address)
+#endif
 
 using namespace std;
 
 #define _MIN(x,y) ((x) < (y) ? (x) : (y))
 #define _MAX(x,y) ((x) > (y) ? (x) : (y))
 
+// Number of elements of a level built at once by a thread in SparseTableRMQ's constructor
+#define __SPARSE_TABLE_BUILD_CHUNK_SIZE	16384
+// Number of queries of MinInRangeBatch whose memory accesses are prefetched together
+#define __RMQ_BATCH_GROUP_SIZE	32
+// RestrictedRMQ: number of elements per block, at most 64 so that the steps between the elements of a block fit in a word
+#define __RESTRICTED_RMQ_BLOCK_SIZE	64
+// SuccinctRMQ: number of 64-bit words per block and per superblock, and number of elements between two samples of the
+// select structure
+#define __SUCCINCT_RMQ_BLOCK_WORDS	8
+#define __SUCCINCT_RMQ_SUPERBLOCK_WORDS	64
+#define __SUCCINCT_RMQ_SELECT_SAMPLE_RATE	4096
+// DynamicRMQ: number of elements per block
+#define __DYNAMIC_RMQ_BLOCK_SIZE	64
+
 namespace Yui
 {
+	// floor(log2(x)) for x > 0, computed with a 256-entry table instead of the floating point log2
+	inline int RMQLog2(unsigned int x)
+	{
+		static const struct Log2Table
+		{
+			unsigned char log2_[256];
+			Log2Table()
+			{
+				log2_[0] = 0;
+				log2_[1] = 0;
+				for (int i = 2; i < 256; ++i)
+					log2_[i] = log2_[i / 2] + 1;
+			}
+		} table;
+		if (x >> 16)
+			return (x >> 24) ? 24 + table.log2_[x >> 24] : 16 + table.log2_[x >> 16];
+		return (x >> 8) ? 8 + table.log2_[x >> 8] : table.log2_[x];
+	}
+
+	// Number of 1 bits of x
+	inline int RMQPopCount(uint64_t x)
+	{
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+	}
+
+	// Excess of each byte read from its least significant bit, where a 1 bit counts +1 and a 0 bit -1: total, minimum after
+	// the first 1 to 8 bits and rightmost position of this minimum (min_[length - 1][byte]), and number of 1 bits
+	struct RMQByteTables
+	{
+		signed char excess_[256];
+		signed char min_[8][256];
+		signed char min_position_[8][256];
+		unsigned char ones_[256];
+
+		RMQByteTables()
+		{
+			for (int byte = 0; byte < 256; ++byte)
+			{
+				int excess = 0;
+				int min = 8;
+				int min_position = 0;
+				int ones = 0;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					excess += ((byte >> bit) & 1) ? 1 : -1;
+					ones += (byte >> bit) & 1;
+					if (excess <= min)
+					{
+						min = excess;
+						min_position = bit;
+					}
+					min_[bit][byte] = static_cast<signed char>(min);
+					min_position_[bit][byte] = static_cast<signed char>(min_position);
+				}
+				excess_[byte] = static_cast<signed char>(excess);
+				ones_[byte] = static_cast<unsigned char>(ones);
+			}
+		}
+
+		static const RMQByteTables &Get()
+		{
+			static const RMQByteTables tables;
+			return tables;
+		}
+	};
+
+	// Rightmost minimum of the excess after bits a to b (included) of word, relative to the excess before bit a. Stores the
+	// position of the bit in the word in 'position'.
+	inline int RMQWordMin(uint64_t word, int a, int b, int &position)
+	{
+		const RMQByteTables &tables = RMQByteTables::Get();
+		word >>= a;
+		int length = b - a + 1;
+		int excess = 0;
+		int min = INT_MAX;
+		int min_position = 0;
+		// Whole bytes then the remaining bits, written so that the comparisons compile to conditional moves
+		for (int k = 0; k < length; k += 8)
+		{
+			unsigned int byte = static_cast<unsigned int>((word >> k) & 0xFF);
+			int prefix = _MIN(length - k, 8) - 1;
+			int byte_min = excess + tables.min_[prefix][byte];
+			bool smaller = (byte_min <= min);
+			min = (smaller ? byte_min : min);
+			min_position = (smaller ? k + tables.min_position_[prefix][byte] : min_position);
+			excess += tables.excess_[byte];
+		}
+		position = a + min_position;
+		return min;
+	}
+
 	// Range Minimum Query algorithm
 	// O(nlog(n)) preprocessing and O(1) queries
-	template<class T>
+	// The table is a single contiguous array of log2(n)+1 levels of n indices. Index is the integer type of the indices
+	// stored in the table: uint16_t halves the memory and the cache footprint of the queries for arrays of at most 65536
+	// elements. Larger arrays would silently truncate the indices, which the constructor asserts against.
+	template<class T, typename Index = int>
 	class SparseTableRMQ
 	{
 	private:
-		// RMQ[i][j]: index of the minimum among A[i], A[i+1], ..., A[i+2^j-1]
-		int **RMQ_;
+		// RMQ_[j*size_ + i]: index of the minimum among A[i], A[i+1], ..., A[i+2^j-1], for i + 2^j <= size_. Level-major, so
+		// that the level is built and read sequentially.
+		std::vector<Index> RMQ_;
 		int size_;
+		int num_levels_;
 		// Used to access the values of the input array since RMQ tables only store indices
-		T *A_;
+		std::vector<T> A_;
 
 	public:
-		SparseTableRMQ(const T *A, int size) : size_(size)
-		{
-			A_ = new T[size];
-			memcpy(A_, A, sizeof(T)*size);
-			int width = log2(size) + 1;
-			RMQ_ = new int*[size];
-			for (int i = 0; i < size; ++i) {
-				RMQ_[i] = new int[width];
-				RMQ_[i][0] = i;
-			}
+		// Each level is built from the previous one. The cells of a level are independent: they are split in chunks built by
+		// 'threads' threads.
+		SparseTableRMQ(const T *A, int size, int threads = 1) : RMQ_(), size_(size), num_levels_(RMQLog2(_MAX(size, 1)) + 1), A_(A, A + size)
+		{
+			assert(size <= 1 || uint64_t(size - 1) <= uint64_t((std::numeric_limits<Index>::max)()));
+			RMQ_.resize(size_t(num_levels_) * size);
+			for (int i = 0; i < size; ++i)
+				RMQ_[i] = Index(i);
 
-			for (int j = 1; j < width; ++j) {
-				for (int i = 0; i < size; ++i) {
-					int b = _MIN(i + (1 << (j - 1)), size - (1 << (j - 1)));
-					if (A[RMQ_[i][j - 1]] < A[RMQ_[b][j - 1]])
-						RMQ_[i][j] = RMQ_[i][j - 1];
-					else
-						RMQ_[i][j] = RMQ_[b][j - 1];
+			for (int j = 1; j < num_levels_; ++j)
+			{
+				const Index *previous = &RMQ_[size_t(j - 1) * size];
+				Index *current = &RMQ_[size_t(j) * size];
+				int half = 1 << (j - 1);
+				int level_size = size - (1 << j) + 1;
+				int num_chunks = (level_size + __SPARSE_TABLE_BUILD_CHUNK_SIZE - 1) / __SPARSE_TABLE_BUILD_CHUNK_SIZE;
+#pragma omp parallel for schedule(static) num_threads(threads > 0 ? threads : 1) if (threads > 1 && num_chunks > 1)
+				for (int chunk = 0; chunk < num_chunks; ++chunk)
+				{
+					int chunk_end = _MIN((chunk + 1) * __SPARSE_TABLE_BUILD_CHUNK_SIZE, level_size);
+					for (int i = chunk * __SPARSE_TABLE_BUILD_CHUNK_SIZE; i < chunk_end; ++i)
+					{
+						Index a = previous[i];
+						Index b = previous[i + half];
+						current[i] = (A_[a] < A_[b] ? a : b);
+					}
 				}
 			}
 		}
 
-		~SparseTableRMQ() {
-			for (int i = 0; i < size_; ++i)
-				delete[] RMQ_[i];
-			delete[] RMQ_;
-			delete[] A_;
-		}
-		int MinInRange(int i, int j)
+		int MinInRange(int i, int j)	const
 		{
 			if (i > j)
 				return MinInRange(j, i);
@@ -64,182 +197,733 @@ namespace Yui
 			{
 				if (i == j)
 					return i;
-				int l = log2(j - i + 1);
-				int idx1 = RMQ_[i][l];
-				int idx2 = RMQ_[j - (1 << l) + 1][l];
+				int l = RMQLog2(j - i + 1);
+				const Index *level = &RMQ_[size_t(l) * size_];
+				int idx1 = level[i];
+				int idx2 = level[j - (1 << l) + 1];
 				return (A_[idx1] < A_[idx2] ? idx1 : idx2);
 			}
 		}
 
-		inline const int **RMQ()	{ return RMQ_; }
+		// Answers n queries: out[k] = MinInRange(queries[k].first, queries[k].second). A query is two dependent cache misses
+		// (the two cells of the table, then the two values of A), so the queries are processed in groups of
+		// __RMQ_BATCH_GROUP_SIZE: the cells of the whole group are prefetched, then the values, so that the misses of the group
+		// overlap instead of being paid one after the other. The groups are split among 'threads' threads.
+		void MinInRangeBatch(const std::pair<int, int> *queries, size_t n, int *out, int threads = 1)	const
+		{
+			int num_groups = int((n + __RMQ_BATCH_GROUP_SIZE - 1) / __RMQ_BATCH_GROUP_SIZE);
+#pragma omp parallel for schedule(static) num_threads(threads > 0 ? threads : 1) if (threads > 1)
+			for (int group = 0; group < num_groups; ++group)
+			{
+				size_t begin = size_t(group) * __RMQ_BATCH_GROUP_SIZE;
+				int group_size = int(_MIN(n - begin, size_t(__RMQ_BATCH_GROUP_SIZE)));
+				const Index *cells[2 * __RMQ_BATCH_GROUP_SIZE];
+				int idx[2 * __RMQ_BATCH_GROUP_SIZE];
+				for (int k = 0; k < group_size; ++k)
+				{
+					int i = _MIN(queries[begin + k].first, queries[begin + k].second);
+					int j = _MAX(queries[begin + k].first, queries[begin + k].second);
+					// When i == j, level 0 holds i itself
+					int l = RMQLog2(j - i + 1);
+					const Index *level = &RMQ_[size_t(l) * size_];
+					cells[2 * k] = level + i;
+					cells[2 * k + 1] = level + j - (1 << l) + 1;
+					__RMQ_PREFETCH(cells[2 * k]);
+					__RMQ_PREFETCH(cells[2 * k + 1]);
+				}
+				for (int k = 0; k < 2 * group_size; ++k)
+				{
+					idx[k] = *cells[k];
+					__RMQ_PREFETCH(&A_[idx[k]]);
+				}
+				for (int k = 0; k < group_size; ++k)
+					out[begin + k] = (A_[idx[2 * k]] < A_[idx[2 * k + 1]] ? idx[2 * k] : idx[2 * k + 1]);
+			}
+		}
+
+		// Returns the level j of the table, of size() - 2^j + 1 indices
+		inline const Index *RMQ(int j)	const	{ return &RMQ_[size_t(j) * size_]; }
+		inline int size()	const	{ return size_; }
+		inline size_t AllocatedBytes()	const	{ return RMQ_.capacity() * sizeof(Index) + A_.capacity() * sizeof(T); }
 	};
 
 	// Range Minimum Query for the special case of integer arrays in which each pair of consecutive elements
 	// is separated by distance 1.
 	// O(n) preprocessing and O(1) queries
+	// The array is split into blocks of __RESTRICTED_RMQ_BLOCK_SIZE elements. A block is stored as its first element and a
+	// 64-bit word whose bit k is set if element k+1 is element k plus 1, so that any element is recovered with a population
+	// count, and the minimum of a range inside a block is found with at most 8 lookups in the byte tables shared with
+	// SuccinctRMQ. The blocks are stored in a single contiguous array, and a SparseTableRMQ over their minima answers the
+	// whole blocks of a query. The input array is not kept. Ties are resolved to the rightmost minimum.
 	class RestrictedRMQ
 	{
 	private:
-		// Used to access the values of the input array since RMQ tables only store indices
-		int *A_;
-
-		// RMQ[i][j]: index of the minimum among A[i], A[i+1], ..., A[i+2^j-1]
-		int **RMQ_;
-		// Stores the minimum in each block of size 'block_size_' of the input array A
-		int *A2_;
-		// Stores the index of the minimum in each block of size 'block_size_' of the input array A
-		int *A2_idx_;
-		// See 'GetIdentifierOf'. Labels each block so that the appropriate RMQ table
-		// is used to get the minimum in range
-		int *block_ids_;
-		int num_blocks_;
-		int block_size_;
-		// RMQ table for all the combinations of blocks of size 'block_size_ and where
-		// consecutive elements differ by 1
-		SparseTableRMQ<int> **RMQ_tables_;
-		SparseTableRMQ<int> *A2_RMQ_table_;
-
-		// Calculate the minimum in each block of A and store the result in 'A2_'
-		void CalculateBlockMinimum(const int *A, int size)
-		{
-			A2_ = new int[num_blocks_];
-			A2_idx_ = new int[num_blocks_];
-			for (int block_idx = 0; block_idx < num_blocks_; ++block_idx)
+		struct Block
+		{
+			uint64_t steps_;
+			int first_;
+			int min_;
+			// Index in A of the rightmost minimum of the block
+			int min_index_;
+		};
+
+		std::vector<Block> blocks_;
+		int size_;
+		SparseTableRMQ<int> *block_RMQ_;
+
+		inline int Value(int i)	const
+		{
+			const Block &block = blocks_[i / __RESTRICTED_RMQ_BLOCK_SIZE];
+			int k = i % __RESTRICTED_RMQ_BLOCK_SIZE;
+			return block.first_ + 2 * RMQPopCount(block.steps_ & ((uint64_t(1) << k) - 1)) - k;
+		}
+
+		// Position in the block of the rightmost minimum among its elements a to b (included)
+		static inline int MinInBlock(const Block &block, int a, int b)
+		{
+			if (a == b)
+				return a;
+			int position;
+			// The excess after bit k is the value of element k+1 relative to element a
+			int min = RMQWordMin(block.steps_, a, b - 1, position);
+			return (min <= 0 ? position + 1 : a);
+		}
+
+	public:
+		RestrictedRMQ(const int *A, int size) : size_(size)
+		{
+			int num_blocks = (size + __RESTRICTED_RMQ_BLOCK_SIZE - 1) / __RESTRICTED_RMQ_BLOCK_SIZE;
+			blocks_.resize(num_blocks);
+			std::vector<int> block_min(num_blocks);
+			for (int block_idx = 0; block_idx < num_blocks; ++block_idx)
 			{
-				int block_end = _MIN((block_idx + 1)*block_size_, size);
-				A2_[block_idx] = INT_MAX;
-				A2_idx_[block_idx] = 0;
-				for (int j = block_idx*block_size_; j<block_end; ++j)
+				int block_start = block_idx * __RESTRICTED_RMQ_BLOCK_SIZE;
+				int block_end = _MIN(block_start + __RESTRICTED_RMQ_BLOCK_SIZE, size);
+				Block &block = blocks_[block_idx];
+				block.first_ = A[block_start];
+				block.steps_ = 0;
+				for (int k = 0; block_start + k + 1 < block_end; ++k)
 				{
-					if (A2_[block_idx] > A[j]) {
-						A2_[block_idx] = A[j];
-						A2_idx_[block_idx] = j;
-					}
+					if (A[block_start + k + 1] > A[block_start + k])
+						block.steps_ |= uint64_t(1) << k;
 				}
+				block.min_index_ = block_start + MinInBlock(block, 0, block_end - block_start - 1);
+				block.min_ = Value(block.min_index_);
+				block_min[block_idx] = block.min_;
 			}
+			block_RMQ_ = new SparseTableRMQ<int>(block_min.data(), num_blocks);
 		}
 
-		void BuildRestrictedRMQTables()
-		{
-			int num_RMQ_tables = (1 << (block_size_ - 1));
-			RMQ_tables_ = new SparseTableRMQ<int>*[num_RMQ_tables];
-			std::vector<int> A;
-			for (int j = 0; j < block_size_; ++j)
-				A.push_back(0);
-			int num_bits = ceil(log2(num_RMQ_tables));
-			for (int i = 0; i < num_RMQ_tables; ++i) {
-				// When writing i in binary representation, i = 0011100...
-				// A[0] = 0 and the following elements are computed using the following rule:
-				// if the k-th bit of i is 0, A[k+1] = A[k]+1
-				// otherwise, A[k+1] = A[k]-1
-
-				for (int j = 1; j <= num_bits; ++j) {
-					if ((1 << (j - 1)) & i)
-						A[j] = A[j - 1] - 1;
-					else
-						A[j] = A[j - 1] + 1;
+		~RestrictedRMQ()	{ delete block_RMQ_; }
+
+		RestrictedRMQ(const RestrictedRMQ &) = delete;
+		RestrictedRMQ &operator=(const RestrictedRMQ &) = delete;
+
+		int MinInRange(int beg, int end)	const
+		{
+			if (beg > end)
+				return MinInRange(end, beg);
+			// Find the blocks in which beg and end indices are included
+			int block_first = beg / __RESTRICTED_RMQ_BLOCK_SIZE;
+			int block_last = end / __RESTRICTED_RMQ_BLOCK_SIZE;
+			int block_first_start = block_first * __RESTRICTED_RMQ_BLOCK_SIZE;
+			int block_last_start = block_last * __RESTRICTED_RMQ_BLOCK_SIZE;
+			if (block_first == block_last)
+				return block_first_start + MinInBlock(blocks_[block_first], beg - block_first_start, end - block_first_start);
+
+			int min_index = block_first_start + MinInBlock(blocks_[block_first], beg - block_first_start, __RESTRICTED_RMQ_BLOCK_SIZE - 1);
+			int min = Value(min_index);
+			// Whole blocks in between
+			if (block_first + 1 < block_last)
+			{
+				const Block &block = blocks_[block_RMQ_->MinInRange(block_first + 1, block_last - 1)];
+				if (block.min_ <= min)
+				{
+					min = block.min_;
+					min_index = block.min_index_;
 				}
+			}
+			int idx = block_last_start + MinInBlock(blocks_[block_last], 0, end - block_last_start);
+			return (Value(idx) <= min ? idx : min_index);
+		}
 
-				RMQ_tables_[i] = new SparseTableRMQ<int>(&A[0], block_size_);
+		// Answers n queries: out[k] = MinInRange(queries[k].first, queries[k].second). The blocks of a group of
+		// __RMQ_BATCH_GROUP_SIZE queries are prefetched before the queries are answered, and the groups are split among
+		// 'threads' threads.
+		void MinInRangeBatch(const std::pair<int, int> *queries, size_t n, int *out, int threads = 1)	const
+		{
+			int num_groups = int((n + __RMQ_BATCH_GROUP_SIZE - 1) / __RMQ_BATCH_GROUP_SIZE);
+#pragma omp parallel for schedule(static) num_threads(threads > 0 ? threads : 1) if (threads > 1)
+			for (int group = 0; group < num_groups; ++group)
+			{
+				size_t begin = size_t(group) * __RMQ_BATCH_GROUP_SIZE;
+				size_t end = _MIN(n, begin + __RMQ_BATCH_GROUP_SIZE);
+				for (size_t k = begin; k < end; ++k)
+				{
+					__RMQ_PREFETCH(&blocks_[queries[k].first / __RESTRICTED_RMQ_BLOCK_SIZE]);
+					__RMQ_PREFETCH(&blocks_[queries[k].second / __RESTRICTED_RMQ_BLOCK_SIZE]);
+				}
+				for (size_t k = begin; k < end; ++k)
+					out[k] = MinInRange(queries[k].first, queries[k].second);
 			}
 		}
 
-		void CalculateBlockIds(const int *A, int size)
+		inline int size()	const	{ return size_; }
+		inline size_t AllocatedBytes()	const	{ return blocks_.capacity() * sizeof(Block) + block_RMQ_->AllocatedBytes(); }
+	};
+
+	// Succinct Range Minimum Query: about 3 bits per element, without keeping a copy of the input array. O(n) preprocessing
+	// and constant time queries, apart from a binary search over the superblocks between two samples of the select structure.
+	// A query costs about ten times a SparseTableRMQ query, which uses 32*log(n) bits per element.
+	// The input is encoded by the stack of the linear construction of its Cartesian tree: when element i is pushed, the
+	// larger elements on top of the stack are popped first. Each pop is written as a 0 bit and each push as a 1 bit, so the
+	// sequence has at most 2n bits, and the excess (number of 1 minus number of 0) after the bit of element i is the height
+	// of the stack. The stack holds the suffix minima of the elements pushed so far, hence the minimum of A[i..j] is the
+	// element below which the stack never goes between the pushes of i and j: if the rightmost minimum excess strictly after
+	// the bit of i and up to the bit of j is below the height after i, the answer is the element pushed right after that
+	// position, otherwise it is i (see Fischer and Heun, Space-efficient preprocessing schemes for range minimum queries).
+	// The queries use rank and select on the bits, and a rightmost minimum excess search made of byte lookup tables inside
+	// words, minimum tables of the words and of the blocks of __SUCCINCT_RMQ_BLOCK_WORDS words inside superblocks of
+	// __SUCCINCT_RMQ_SUPERBLOCK_WORDS words, and a sparse table over the superblocks. A query scans at most a few words and
+	// blocks at each end of its range. Ties are resolved to the leftmost minimum.
+	// The 3 bits per element are the size of the built structure. The construction also reads the input array and keeps the
+	// stack as a temporary array of up to n ints (32 bits per element on increasing input), freed before the tables are
+	// built.
+	class SuccinctRMQ
+	{
+	private:
+		int size_;
+		size_t num_bits_;
+		// Bit k is 1 for a push and 0 for a pop
+		std::vector<uint64_t> words_;
+		// Number of 1 bits before each superblock
+		std::vector<uint64_t> superblock_rank_;
+		// Number of 1 bits before each word, from the beginning of its superblock
+		std::vector<uint16_t> word_rank_;
+		// Minimum excess after the bits of each word, relative to the excess before the word
+		std::vector<signed char> word_min_;
+		// Minimum excess after the bits of each block, relative to the excess before its superblock
+		std::vector<int16_t> block_min_;
+		// Minimum excess in each superblock
+		std::vector<int> superblock_min_;
+		// superblock_table_[j*num_superblocks_ + s]: rightmost superblock of minimum excess among s, s+1, ..., s+2^j-1
+		std::vector<int> superblock_table_;
+		int num_superblocks_;
+		// Position of the bit of each element whose index is a multiple of __SUCCINCT_RMQ_SELECT_SAMPLE_RATE
+		std::vector<uint64_t> select_samples_;
+
+		inline int Bit(size_t k)	const	{ return static_cast<int>((words_[k >> 6] >> (k & 63)) & 1); }
+
+		// Number of 1 bits before bit k
+		inline size_t Rank(size_t k)	const
+		{
+			size_t w = k >> 6;
+			size_t rank = superblock_rank_[w / __SUCCINCT_RMQ_SUPERBLOCK_WORDS] + word_rank_[w];
+			if (k & 63)
+				rank += RMQPopCount(words_[w] & ((uint64_t(1) << (k & 63)) - 1));
+			return rank;
+		}
+
+		// Excess before bit k
+		inline long long Excess(size_t k)	const	{ return 2 * static_cast<long long>(Rank(k)) - static_cast<long long>(k); }
+		inline long long SuperblockExcess(size_t superblock)	const
 		{
-			block_ids_ = new int[num_blocks_];
-			for (int block_idx = 0; block_idx < num_blocks_; ++block_idx)
+			return 2 * static_cast<long long>(superblock_rank_[superblock]) - static_cast<long long>(superblock * __SUCCINCT_RMQ_SUPERBLOCK_WORDS * 64);
+		}
+		inline long long WordExcess(size_t w)	const
+		{
+			return 2 * static_cast<long long>(superblock_rank_[w / __SUCCINCT_RMQ_SUPERBLOCK_WORDS] + word_rank_[w]) - static_cast<long long>(w << 6);
+		}
+
+		// Position of the bit of element i
+		size_t Select(int i)	const
+		{
+			size_t sample = size_t(i) / __SUCCINCT_RMQ_SELECT_SAMPLE_RATE;
+			if (size_t(i) % __SUCCINCT_RMQ_SELECT_SAMPLE_RATE == 0)
+				return select_samples_[sample];
+			// Last superblock with at most i 1 bits before it, between the superblocks of this sample and of the next one
+			size_t first = select_samples_[sample] / (64 * __SUCCINCT_RMQ_SUPERBLOCK_WORDS);
+			size_t last = (sample + 1 < select_samples_.size() ? select_samples_[sample + 1] / (64 * __SUCCINCT_RMQ_SUPERBLOCK_WORDS) + 1 : size_t(num_superblocks_));
+			size_t superblock = std::upper_bound(superblock_rank_.begin() + first, superblock_rank_.begin() + last, uint64_t(i)) - superblock_rank_.begin() - 1;
+			// Last word of the superblock with at most i 1 bits before it
+			size_t word_begin = superblock * __SUCCINCT_RMQ_SUPERBLOCK_WORDS;
+			size_t word_end = _MIN(word_begin + __SUCCINCT_RMQ_SUPERBLOCK_WORDS, words_.size());
+			unsigned int remaining = static_cast<unsigned int>(i - superblock_rank_[superblock]);
+			size_t w = std::upper_bound(word_rank_.begin() + word_begin, word_rank_.begin() + word_end, remaining) - word_rank_.begin() - 1;
+			remaining -= word_rank_[w];
+			// Bit of rank 'remaining' in the word
+			const RMQByteTables &tables = RMQByteTables::Get();
+			uint64_t word = words_[w];
+			int position = 0;
+			while (tables.ones_[word & 0xFF] <= remaining)
+			{
+				remaining -= tables.ones_[word & 0xFF];
+				word >>= 8;
+				position += 8;
+			}
+			while (true)
 			{
-				int block_start = block_idx*block_size_;
-				int block_end = _MIN((block_idx + 1)*block_size_, size);
-				block_ids_[block_idx] = GetIdentifierOf(A + block_start, block_end - block_start);
+				if (word & 1)
+				{
+					if (remaining == 0)
+						break;
+					--remaining;
+				}
+				word >>= 1;
+				++position;
 			}
+			return (w << 6) + position;
 		}
 
-	public:
-		RestrictedRMQ(const int *A, int size)
-		{
-			A_ = new int[size];
-			memcpy(A_, A, sizeof(int)*size);
-			block_size_ = _MAX(1, log2(size) / 2);
-			// Split A into blocks of size log2(size)/2
-			num_blocks_ = ceil(double(size) / block_size_);
-			CalculateBlockMinimum(A, size);
-			BuildRestrictedRMQTables();
-			CalculateBlockIds(A, size);
-			A2_RMQ_table_ = new SparseTableRMQ<int>(A2_, num_blocks_);
-		}
-
-		~RestrictedRMQ()
-		{
-			int num_RMQ_tables = (1 << (block_size_ - 1));
-			for (int i = 0; i < num_RMQ_tables; ++i)
-				delete RMQ_tables_[i];
-			delete[] RMQ_tables_;
-			delete[] A2_;
-			delete[] A2_idx_;
-			delete A2_RMQ_table_;
-			delete[] A_;
-		}
-
-		// 'A' must be an array such that |A[k+1]-A[k]| = 1
-		// Returns an integer defined as sum over i from 0 to size-2 included
-		// of (2^i if A[i+1]-A[i] == -1 and 0 otherwise)
-		int GetIdentifierOf(const int *A, int size)
-		{
-			int res = 0;
-			for (int i = 0; i <= size - 2; ++i) {
-				if (A[i + 1] - A[i] == -1)
-					res += (1 << i);
+		inline int WordMin(size_t w, int a, int b, int &position)	const	{ return RMQWordMin(words_[w], a, b, position); }
+
+		// Rightmost minimum excess found so far by a scan from left to right: a bit position, or a whole word, block or
+		// superblock which is only searched at the end
+		enum MinimumKind { kBit, kWord, kBlock, kSuperblock };
+		struct Minimum
+		{
+			long long excess_;
+			MinimumKind kind_;
+			size_t index_;
+
+			inline void Update(long long excess, MinimumKind kind, size_t index)
+			{
+				if (excess <= excess_)
+				{
+					excess_ = excess;
+					kind_ = kind;
+					index_ = index;
+				}
 			}
-			return res;
+		};
+
+		void WordsMin(size_t first, size_t last, Minimum &min)	const
+		{
+			for (size_t w = first; w <= last; ++w)
+				min.Update(WordExcess(w) + word_min_[w], kWord, w);
 		}
 
-		int MinInRange(int beg, int end)
+		void BlocksMin(size_t first, size_t last, Minimum &min)	const
 		{
-			if (beg > end)
-				return MinInRange(end, beg);
-			else
+			const size_t kBlocksPerSuperblock = __SUCCINCT_RMQ_SUPERBLOCK_WORDS / __SUCCINCT_RMQ_BLOCK_WORDS;
+			for (size_t block = first; block <= last; ++block)
+				min.Update(SuperblockExcess(block / kBlocksPerSuperblock) + block_min_[block], kBlock, block);
+		}
+
+		// Whole words first to last (included) of the same superblock
+		void WordsInSuperblockMin(size_t first, size_t last, Minimum &min)	const
+		{
+			size_t first_block = first / __SUCCINCT_RMQ_BLOCK_WORDS;
+			size_t last_block = last / __SUCCINCT_RMQ_BLOCK_WORDS;
+			if (first_block == last_block)
+			{
+				WordsMin(first, last, min);
+				return;
+			}
+			WordsMin(first, (first_block + 1) * __SUCCINCT_RMQ_BLOCK_WORDS - 1, min);
+			if (first_block + 1 < last_block)
+				BlocksMin(first_block + 1, last_block - 1, min);
+			WordsMin(last_block * __SUCCINCT_RMQ_BLOCK_WORDS, last, min);
+		}
+
+		// Rightmost superblock of minimum excess among superblocks first to last (included)
+		int SuperblocksMin(int first, int last)	const
+		{
+			int l = RMQLog2(last - first + 1);
+			const int *level = &superblock_table_[size_t(l) * num_superblocks_];
+			int a = level[first];
+			int b = level[last - (1 << l) + 1];
+			return (superblock_min_[b] <= superblock_min_[a] ? b : a);
+		}
+
+		// Rightmost position of the minimum excess after bits x to y (included), x <= y. Stores the excess in 'excess'.
+		size_t ExcessMin(size_t x, size_t y, long long &excess)	const
+		{
+			size_t wx = x >> 6;
+			size_t wy = y >> 6;
+			int position;
+			if (wx == wy)
+			{
+				excess = Excess(x) + WordMin(wx, int(x & 63), int(y & 63), position);
+				return (wx << 6) + position;
+			}
+
+			Minimum min = { LLONG_MAX, kBit, 0 };
+			long long word_min = Excess(x) + WordMin(wx, int(x & 63), 63, position);
+			min.Update(word_min, kBit, (wx << 6) + position);
+			if (wx + 1 < wy)
 			{
-				// Find the blocks in which beg and end indices are included
-				int block_first = beg / block_size_;
-				int block_last = end / block_size_;
-
-				// Index of 'beg' with regards to a block
-				int block_first_beg_idx = beg - block_first*block_size_;
-				// Index of 'end' with regards to a block
-				int block_last_end_idx = end - block_last*block_size_;
-
-				int idx1 = RMQ_tables_[block_ids_[block_first]]->MinInRange(block_first_beg_idx, (block_first == block_last) ? block_last_end_idx : block_size_ - 1);
-				//  Retrieve the index in A of the minimum element in the block 'block_first' 
-				idx1 = idx1 + block_first*block_size_;
-
-				int idx2 = idx1;
-				if (block_first + 1 <= block_last - 1) {
-					idx2 = A2_RMQ_table_->MinInRange(block_first + 1, block_last - 1);
-					//  Retrieve the index in A of the minimum element in the blocks A2 
-					idx2 = A2_idx_[idx2];
+				size_t first = wx + 1;
+				size_t last = wy - 1;
+				size_t first_superblock = first / __SUCCINCT_RMQ_SUPERBLOCK_WORDS;
+				size_t last_superblock = last / __SUCCINCT_RMQ_SUPERBLOCK_WORDS;
+				if (first_superblock == last_superblock)
+					WordsInSuperblockMin(first, last, min);
+				else
+				{
+					WordsInSuperblockMin(first, (first_superblock + 1) * __SUCCINCT_RMQ_SUPERBLOCK_WORDS - 1, min);
+					if (first_superblock + 1 < last_superblock)
+					{
+						int superblock = SuperblocksMin(int(first_superblock + 1), int(last_superblock - 1));
+						min.Update(superblock_min_[superblock], kSuperblock, superblock);
+					}
+					WordsInSuperblockMin(last_superblock * __SUCCINCT_RMQ_SUPERBLOCK_WORDS, last, min);
 				}
+			}
+			word_min = WordExcess(wy) + WordMin(wy, 0, int(y & 63), position);
+			min.Update(word_min, kBit, (wy << 6) + position);
+
+			// Narrow a whole superblock, block or word down to the bit, keeping the rightmost minimum at each step
+			excess = min.excess_;
+			if (min.kind_ == kSuperblock)
+			{
+				const size_t kBlocksPerSuperblock = __SUCCINCT_RMQ_SUPERBLOCK_WORDS / __SUCCINCT_RMQ_BLOCK_WORDS;
+				min.excess_ = LLONG_MAX;
+				BlocksMin(min.index_ * kBlocksPerSuperblock, (min.index_ + 1) * kBlocksPerSuperblock - 1, min);
+			}
+			if (min.kind_ == kBlock)
+			{
+				min.excess_ = LLONG_MAX;
+				WordsMin(min.index_ * __SUCCINCT_RMQ_BLOCK_WORDS, (min.index_ + 1) * __SUCCINCT_RMQ_BLOCK_WORDS - 1, min);
+			}
+			if (min.kind_ == kWord)
+			{
+				WordMin(min.index_, 0, 63, position);
+				return (min.index_ << 6) + position;
+			}
+			return min.index_;
+		}
 
-				int idx3 = RMQ_tables_[block_ids_[block_last]]->MinInRange((block_first == block_last) ? block_first_beg_idx : 0, block_last_end_idx);
-				//  Retrieve the index in A of the minimum element in the block 'block_last' 
-				idx3 = idx3 + block_last*block_size_;
+	public:
+		template<class T>
+		SuccinctRMQ(const T *A, int size) : size_(size), num_bits_(0)
+		{
+			words_.assign(_MAX(size_t(1), (2 * size_t(size) + 63) / 64), 0);
+			{
+				std::vector<int> stack;
+				for (int i = 0; i < size; ++i)
+				{
+					while (!stack.empty() && A[i] < A[stack.back()])
+					{
+						stack.pop_back();
+						++num_bits_;
+					}
+					if (i % __SUCCINCT_RMQ_SELECT_SAMPLE_RATE == 0)
+						select_samples_.push_back(num_bits_);
+					stack.push_back(i);
+					words_[num_bits_ >> 6] |= uint64_t(1) << (num_bits_ & 63);
+					++num_bits_;
+				}
+			}
+			words_.resize(_MAX(size_t(1), (num_bits_ + 63) / 64));
 
-				if (A_[idx1] < A_[idx2])
+			size_t num_words = words_.size();
+			num_superblocks_ = int((num_words + __SUCCINCT_RMQ_SUPERBLOCK_WORDS - 1) / __SUCCINCT_RMQ_SUPERBLOCK_WORDS);
+			superblock_rank_.resize(num_superblocks_);
+			superblock_min_.resize(num_superblocks_);
+			word_rank_.resize(num_words);
+			word_min_.resize(num_words);
+			block_min_.resize((num_words + __SUCCINCT_RMQ_BLOCK_WORDS - 1) / __SUCCINCT_RMQ_BLOCK_WORDS);
+			uint64_t rank = 0;
+			long long excess = 0;
+			for (size_t w = 0; w < num_words; ++w)
+			{
+				size_t superblock = w / __SUCCINCT_RMQ_SUPERBLOCK_WORDS;
+				if (w % __SUCCINCT_RMQ_SUPERBLOCK_WORDS == 0)
 				{
-					if (A_[idx1] < A_[idx3])
-						return idx1;
-					else
-						return idx3;
+					superblock_rank_[superblock] = rank;
+					superblock_min_[superblock] = INT_MAX;
 				}
-				else
+				if (w % __SUCCINCT_RMQ_BLOCK_WORDS == 0)
+					block_min_[w / __SUCCINCT_RMQ_BLOCK_WORDS] = INT16_MAX;
+				word_rank_[w] = static_cast<uint16_t>(rank - superblock_rank_[superblock]);
+				// Only the bits of the sequence count in the last word
+				int num_valid_bits = int(_MIN(size_t(64), num_bits_ - (w << 6)));
+				int position;
+				int min = (num_valid_bits > 0 ? WordMin(w, 0, num_valid_bits - 1, position) : 0);
+				word_min_[w] = static_cast<signed char>(min);
+				int16_t &block_min = block_min_[w / __SUCCINCT_RMQ_BLOCK_WORDS];
+				block_min = static_cast<int16_t>(_MIN(static_cast<long long>(block_min), excess - SuperblockExcess(superblock) + min));
+				superblock_min_[superblock] = int(_MIN(static_cast<long long>(superblock_min_[superblock]), excess + min));
+				int ones = RMQPopCount(words_[w]);
+				rank += ones;
+				excess += 2 * ones - num_valid_bits;
+			}
+
+			int num_levels = RMQLog2(_MAX(num_superblocks_, 1)) + 1;
+			superblock_table_.resize(size_t(num_levels) * num_superblocks_);
+			for (int s = 0; s < num_superblocks_; ++s)
+				superblock_table_[s] = s;
+			for (int j = 1; j < num_levels; ++j)
+			{
+				const int *previous = &superblock_table_[size_t(j - 1) * num_superblocks_];
+				int *current = &superblock_table_[size_t(j) * num_superblocks_];
+				int half = 1 << (j - 1);
+				for (int s = 0; s + (1 << j) <= num_superblocks_; ++s)
+				{
+					int a = previous[s];
+					int b = previous[s + half];
+					current[s] = (superblock_min_[b] <= superblock_min_[a] ? b : a);
+				}
+			}
+		}
+
+		// Returns the index of the leftmost minimum among A[i..j]
+		int MinInRange(int i, int j)	const
+		{
+			if (i > j)
+				return MinInRange(j, i);
+			if (i == j)
+				return i;
+			size_t bit_i = Select(i);
+			size_t bit_j = Select(j);
+			long long min;
+			size_t position = ExcessMin(bit_i + 1, bit_j, min);
+			// The stack went below the height after pushing i: the minimum is the element pushed right after 'position'
+			if (min < Excess(bit_i + 1))
+				return static_cast<int>(Rank(position));
+			return i;
+		}
+
+		inline int size()	const	{ return size_; }
+		inline size_t AllocatedBytes()	const
+		{
+			return words_.capacity() * sizeof(uint64_t) + superblock_rank_.capacity() * sizeof(uint64_t) + word_rank_.capacity() * sizeof(uint16_t) +
+				word_min_.capacity() + block_min_.capacity() * sizeof(int16_t) + superblock_min_.capacity() * sizeof(int) + superblock_table_.capacity() * sizeof(int) +
+				select_samples_.capacity() * sizeof(uint64_t);
+		}
+	};
+
+	namespace DynamicRMQScan
+	{
+		template<typename T>
+		inline int ScalarMinIndex(const T *data, int n)
+		{
+			int min_index = 0;
+			for (int k = 1; k < n; ++k)
+			{
+				if (data[k] < data[min_index])
+					min_index = k;
+			}
+			return min_index;
+		}
+
+		// Returns the index of the leftmost minimum among data[0..n-1], n > 0
+		template<typename T>
+		inline int MinIndex(const T *data, int n)
+		{
+			return ScalarMinIndex(data, n);
+		}
+
+#ifdef __SORTING_NETWORK_SIMD
+		// The minimum is reduced with vertical min instructions over registers of W lanes, without data-dependent branches,
+		// then its first occurrence is searched.
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 inline int SIMDMinIndex(const typename Lanes::Element *data, int n)
+		{
+			typedef typename Lanes::Element Element;
+			const int W = Lanes::kNumLanes;
+			if (n < 2 * W)
+				return ScalarMinIndex(data, n);
+			__m128i min_lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+			int k = W;
+			for (; k + W <= n; k += W)
+				min_lanes = Lanes::Min(min_lanes, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + k)));
+			Element lanes[W];
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), min_lanes);
+			Element min = lanes[0];
+			for (int lane = 1; lane < W; ++lane)
+				min = (lanes[lane] < min ? lanes[lane] : min);
+			for (; k < n; ++k)
+				min = (data[k] < min ? data[k] : min);
+			k = 0;
+			while (min < data[k])
+				++k;
+			return k;
+		}
+
+		template<>
+		inline int MinIndex<int>(const int *data, int n)
+		{
+			return SortingNetwork::Int32Lanes::IsSupported() ? SIMDMinIndex<SortingNetwork::Int32Lanes>(data, n) : ScalarMinIndex(data, n);
+		}
+
+		template<>
+		inline int MinIndex<float>(const float *data, int n)
+		{
+			return SortingNetwork::FloatLanes::IsSupported() ? SIMDMinIndex<SortingNetwork::FloatLanes>(data, n) : ScalarMinIndex(data, n);
+		}
+
+		template<>
+		inline int MinIndex<long long>(const long long *data, int n)
+		{
+			return SortingNetwork::Int64Lanes::IsSupported() ? SIMDMinIndex<SortingNetwork::Int64Lanes>(data, n) : ScalarMinIndex(data, n);
+		}
+#endif
+	}
+
+	// Dynamic Range Minimum Query: the elements can be updated after the construction, where the static classes above need to
+	// be rebuilt in O(n) or O(n*log(n)).
+	// The elements are split into blocks of __DYNAMIC_RMQ_BLOCK_SIZE elements whose minima are the leaves of a segment tree
+	// stored as an implicit array (the children of node k are 2k and 2k+1), each node holding its minimum and its index. The blocks are scanned with SIMD min instructions
+	// for int, float and long long (see SortingNetwork.h).
+	// - MinInRange scans the two blocks at the ends of the range and combines O(log(n/B)) nodes of the tree. On arrays larger
+	//   than the caches, the cache misses of the scans and of the tree make it about ten times slower than a SparseTableRMQ
+	//   query, for 2n/B nodes instead of n*log(n) indices.
+	// - Update rescans the block of the element only when its minimum grows, then updates the O(log(n/B)) ancestors: about
+	//   as fast as a query, instead of an O(n*log(n)) rebuild of a static table.
+	// - The bulk Update rescans each modified block once and updates each of their common ancestors once.
+	// Ties are resolved to the leftmost minimum. O(n) preprocessing.
+	template<class T>
+	class DynamicRMQ
+	{
+	private:
+		std::vector<T> A_;
+		int size_;
+		int num_blocks_;
+		// Number of leaves of the tree, the smallest power of 2 >= num_blocks_
+		int num_leaves_;
+		// Minimum of the subtree of a node of the tree and index of its leftmost occurrence in A_, stored together so that
+		// a node is read in a single access. index_ is -1 for the leaves past the last block.
+		struct Node
+		{
+			T min_;
+			int index_;
+		};
+		std::vector<Node> tree_;
+
+		inline const Node &Combine(const Node &left, const Node &right)	const
+		{
+			if (left.index_ < 0)
+				return right;
+			if (right.index_ < 0)
+				return left;
+			return (right.min_ < left.min_ ? right : left);
+		}
+
+		inline void UpdateNode(int node)	{ tree_[node] = Combine(tree_[2 * node], tree_[2 * node + 1]); }
+
+		void ScanBlock(int block)
+		{
+			int begin = block * __DYNAMIC_RMQ_BLOCK_SIZE;
+			int end = _MIN(begin + __DYNAMIC_RMQ_BLOCK_SIZE, size_);
+			int min_index = begin + DynamicRMQScan::MinIndex(&A_[begin], end - begin);
+			Node &leaf = tree_[num_leaves_ + block];
+			leaf.min_ = A_[min_index];
+			leaf.index_ = min_index;
+		}
+
+		// Minimum of the blocks first to last (included)
+		Node MinBlocks(int first, int last)	const
+		{
+			Node left = tree_[first + num_leaves_];
+			Node right = left;
+			for (int l = first + num_leaves_, r = last + num_leaves_ + 1; l < r; l >>= 1, r >>= 1)
+			{
+				if (l & 1)
+					left = Combine(left, tree_[l++]);
+				if (r & 1)
+					right = Combine(tree_[--r], right);
+			}
+			return Combine(left, right);
+		}
+
+	public:
+		DynamicRMQ(const T *A, int size) : A_(A, A + size), size_(size)
+		{
+			num_blocks_ = (size + __DYNAMIC_RMQ_BLOCK_SIZE - 1) / __DYNAMIC_RMQ_BLOCK_SIZE;
+			num_leaves_ = 1;
+			while (num_leaves_ < num_blocks_)
+				num_leaves_ <<= 1;
+			Node empty = { T(), -1 };
+			tree_.assign(2 * num_leaves_, empty);
+			for (int block = 0; block < num_blocks_; ++block)
+				ScanBlock(block);
+			for (int node = num_leaves_ - 1; node >= 1; --node)
+				UpdateNode(node);
+		}
+
+		// Returns the index of the leftmost minimum among A[i..j]
+		int MinInRange(int i, int j)	const
+		{
+			if (i > j)
+				return MinInRange(j, i);
+			int first_block = i / __DYNAMIC_RMQ_BLOCK_SIZE;
+			int last_block = j / __DYNAMIC_RMQ_BLOCK_SIZE;
+			if (first_block == last_block)
+				return i + DynamicRMQScan::MinIndex(&A_[i], j - i + 1);
+			int min_index = i + DynamicRMQScan::MinIndex(&A_[i], (first_block + 1) * __DYNAMIC_RMQ_BLOCK_SIZE - i);
+			if (first_block + 1 < last_block)
+			{
+				Node blocks = MinBlocks(first_block + 1, last_block - 1);
+				if (blocks.min_ < A_[min_index])
+					min_index = blocks.index_;
+			}
+			int last_block_begin = last_block * __DYNAMIC_RMQ_BLOCK_SIZE;
+			int right_index = last_block_begin + DynamicRMQScan::MinIndex(&A_[last_block_begin], j - last_block_begin + 1);
+			return (A_[right_index] < A_[min_index] ? right_index : min_index);
+		}
+
+		// Sets A[i] to value. O(B + log(n/B)).
+		void Update(int i, const T &value)
+		{
+			A_[i] = value;
+			int block = i / __DYNAMIC_RMQ_BLOCK_SIZE;
+			Node &leaf = tree_[num_leaves_ + block];
+			if (value < leaf.min_ || (!(leaf.min_ < value) && i < leaf.index_))
+			{
+				leaf.min_ = value;
+				leaf.index_ = i;
+			}
+			else if (i == leaf.index_)
+				ScanBlock(block);
+			// Minimum of the block unchanged
+			else
+				return;
+			for (int node = (num_leaves_ + block) >> 1; node >= 1; node >>= 1)
+				UpdateNode(node);
+		}
+
+		// Sets A[updates[k].first] to updates[k].second for k = 0..n-1, in this order
+		void Update(const std::pair<int, T> *updates, size_t n)
+		{
+			if (n == 0)
+				return;
+			std::vector<int> nodes(n);
+			for (size_t k = 0; k < n; ++k)
+			{
+				A_[updates[k].first] = updates[k].second;
+				nodes[k] = updates[k].first / __DYNAMIC_RMQ_BLOCK_SIZE;
+			}
+			std::sort(nodes.begin(), nodes.end());
+			nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+			for (size_t k = 0; k < nodes.size(); ++k)
+			{
+				ScanBlock(nodes[k]);
+				nodes[k] += num_leaves_;
+			}
+			// Ancestors level by level, each once
+			while (nodes[0] > 1)
+			{
+				size_t num_nodes = 0;
+				for (size_t k = 0; k < nodes.size(); ++k)
 				{
-					if (A_[idx2] > A_[idx3])
-						return idx3;
-					else
-						return idx2;
+					int node = nodes[k] >> 1;
+					if (num_nodes == 0 || nodes[num_nodes - 1] != node)
+						nodes[num_nodes++] = node;
 				}
+				nodes.resize(num_nodes);
+				for (size_t k = 0; k < num_nodes; ++k)
+					UpdateNode(nodes[k]);
 			}
 		}
+
+		inline const T &operator[](int i)	const	{ return A_[i]; }
+		inline int size()	const	{ return size_; }
+		inline size_t AllocatedBytes()	const
+		{
+			return A_.capacity() * sizeof(T) + tree_.capacity() * sizeof(Node);
+		}
 	};
 }
 
@@ -2,12 +2,46 @@
 #define __SORT_H__
 
 #include "Heap.h"
+#include "SortingNetwork.h"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
 
 #ifndef __MERGE_SORT_GRANULARITY
 // Yui::MergeSort will fall back to std::sort when there are less than __MERGE_SORT_GRANULARITY elements.
 #define __MERGE_SORT_GRANULARITY 100
 #endif
 
+#ifndef __RADIX_SORT_GRANULARITY
+// Yui::RadixSort will fall back to std::stable_sort, so that it stays stable, and Yui::MSDRadixSort to std::sort when there are
+// less than __RADIX_SORT_GRANULARITY elements.
+#define __RADIX_SORT_GRANULARITY 64
+#endif
+
+#ifndef __RADIX_SORT_DIGIT_BITS
+// Number of key bits processed by each pass of Yui::RadixSort. 8 bits keep the per-thread histograms (256 counters) in L1.
+#define __RADIX_SORT_DIGIT_BITS 8
+#endif
+
+#ifndef __SAMPLE_SORT_GRANULARITY
+// Yui::SampleSort will fall back to Yui::MergeSort when there are less than __SAMPLE_SORT_GRANULARITY elements.
+#define __SAMPLE_SORT_GRANULARITY 65536
+#endif
+
+#ifndef __SAMPLE_SORT_NUM_BUCKETS
+// Number of buckets Yui::SampleSort distributes the elements into. Must be a power of 2 not greater than 256.
+#define __SAMPLE_SORT_NUM_BUCKETS 256
+#endif
+
+#ifndef __SAMPLE_SORT_OVERSAMPLING
+// Number of sampled elements per bucket from which the splitters of Yui::SampleSort are picked
+#define __SAMPLE_SORT_OVERSAMPLING 16
+#endif
+
 // Uncomment to divide the two calls to merge sort (on the left and right side of the array to sort) among the available threads
 #define __MERGE_SORT_OMP_SECTIONS
 
@@ -19,46 +53,89 @@ namespace Yui
 		return a < b;
 	}
 
+	// AscendingComparator<T, Comparator>::Is(comparator) returns true if comparator is known to order elements of type T by
+	// increasing order with operator<, which allows Yui::MergeSort to use the sorting networks of SortingNetwork.h
+	template<typename T, typename Comparator>
+	struct AscendingComparator
+	{
+		static inline bool Is(const Comparator &)	{ return false; }
+	};
+
+	template<typename T>
+	struct AscendingComparator<T, bool(*)(T &, T &)>
+	{
+		static inline bool Is(bool(*comparator)(T &, T &))	{ return comparator == &IsLess<T>; }
+	};
+
+	template<typename T>
+	struct AscendingComparator<T, std::less<T>>
+	{
+		static inline bool Is(const std::less<T> &)	{ return true; }
+	};
+
+	// Returns true if the elements pointed by iterators of type T are stored contiguously in memory
+	template<typename T>
+	inline bool IsContiguousIterator()
+	{
+		typedef typename std::iterator_traits<T>::value_type Value;
+		return std::is_pointer<T>::value || std::is_same<T, typename std::vector<Value>::iterator>::value
+			|| std::is_same<T, typename std::vector<Value>::const_iterator>::value;
+	}
+
 	enum Order
 	{
 		Increasing,
 		Decreasing
 	};
 
+	// Sorts the elements between the iterators it_begin and it_end-1 inclusive in increasing order with regards to comparator.
+	// The heap is built in parallel by Yui::MakeHeap, then the maximum is repeatedly moved to the end of the range with
+	// Floyd's bottom-up bubble down.
+	template<typename T, typename Comparator>
+	void HeapSort(T it_begin, T it_end, Comparator comparator, unsigned int threads)
+	{
+		MakeHeap(it_begin, it_end, comparator, threads);
+		SortHeap(it_begin, it_end, comparator);
+	}
+
 	// Sort the elements between the iterators it_begin and it_end-1 inclusive
 	template<typename T>
 	void HeapSort(T it_begin, T it_end, Order order = Order::Increasing)
 	{
-		int num_elements = it_end - it_begin;
 		if (order == Order::Increasing)
-		{
-			std::greater < T::value_type > comparator;
-			for (T it = it_begin + (num_elements >> 1); it > it_begin; --it)
-				Heapify(it, it_begin, it_end, comparator);
-			Heapify(it_begin, it_begin, it_end, comparator);
-			for (T it = it_end - 1; it > it_begin; --it)
-			{
-				T::value_type max = *it_begin;
-				*it_begin = *it;
-				*it = max;
-				BubbleDownNonRecursive(it_begin, it_begin, it, comparator);
-			}
-		}
+			HeapSort(it_begin, it_end, std::less<typename std::iterator_traits<T>::value_type>(), 1);
 		else
+			HeapSort(it_begin, it_end, std::greater<typename std::iterator_traits<T>::value_type>(), 1);
+	}
+
+	// Moves the k smallest elements with regards to comparator between it_begin and it_end-1 inclusive to it_begin...it_begin+k-1
+	// in increasing order. The order of the remaining elements is unspecified. O(n*log(k)) time: a max-heap of the k first elements
+	// is built, then every following element smaller than the root replaces it.
+	template<typename T, typename Comparator>
+	void PartialHeapSort(T it_begin, T it_end, size_t k, Comparator comparator)
+	{
+		size_t num_elements = it_end - it_begin;
+		if (k > num_elements)
+			k = num_elements;
+		if (k == 0)
+			return;
+		T it_middle = it_begin + k;
+		MakeHeap(it_begin, it_middle, comparator);
+		for (T it = it_middle; it < it_end; ++it)
 		{
-			std::less < T::value_type > comparator;
-			for (T it = it_begin + (num_elements >> 1); it > it_begin; --it)
-				Heapify(it, it_begin, it_end, comparator);
-			Heapify(it_begin, it_begin, it_end, comparator);
-			for (T it = it_end - 1; it > it_begin; --it)
+			if (comparator(*it, *it_begin))
 			{
-				T::value_type min = *it_begin;
-				*it_begin = *it;
-				*it = min;
-				BubbleDownNonRecursive(it_begin, it_begin, it, comparator);
+				std::swap(*it, *it_begin);
+				BottomUpBubbleDown(it_begin, 0, k, comparator);
 			}
 		}
+		SortHeap(it_begin, it_middle, comparator);
+	}
 
+	template<typename T>
+	void PartialHeapSort(T it_begin, T it_end, size_t k)
+	{
+		PartialHeapSort(it_begin, it_end, k, std::less<typename std::iterator_traits<T>::value_type>());
 	}
 
 	template<typename T, typename Comparator>
@@ -70,7 +147,12 @@ namespace Yui
 		T it_2_end = it_array_2 + array_2_size;
 
 		T::value_type *buffer = new T::value_type[array_1_size + array_2_size];
-		for (size_t buffer_idx = 0; buffer_idx < array_1_size + array_2_size; ++buffer_idx)
+		// Bitonic merge kernel for primitive types ordered by operator<. The sizes are tested first since an empty array may
+		// start at the end of the container, which must not be dereferenced.
+		bool merged = array_1_size && array_2_size
+			&& IsContiguousIterator<T>() && AscendingComparator<T::value_type, Comparator>::Is(comparator)
+			&& SortingNetworkMerge(&*it_array_1, array_1_size, &*it_array_2, array_2_size, buffer);
+		for (size_t buffer_idx = 0; !merged && buffer_idx < array_1_size + array_2_size; ++buffer_idx)
 		{
 			if (it_2 == it_2_end || (it_1 != it_1_end && comparator(*it_1, *it_2)))
 			{
@@ -85,7 +167,7 @@ namespace Yui
 		}
 		for (size_t buffer_idx = 0; buffer_idx < array_1_size + array_2_size; ++buffer_idx)
 			*(it_array_1 + buffer_idx) = buffer[buffer_idx];
-		delete buffer;
+		delete[] buffer;
 	}
 
 	template<typename T, typename U, typename Comparator>
@@ -126,6 +208,22 @@ namespace Yui
 		return it_end;
 	}
 
+	// Returns the first element between it and it+array_size-1 inclusive which is greater than value
+	template<typename T, typename V, typename Comparator>
+	T UpperBinarySearch(V value, T it, size_t array_size, Comparator comparator)
+	{
+		T it_end = it + array_size;
+		while (it < it_end)
+		{
+			T it_mid = it + ((it_end - it) / 2);
+			if (comparator(value, *it_mid))
+				it_end = it_mid;
+			else
+				it = it_mid + 1;
+		}
+		return it_end;
+	}
+
 	// O(n) work
 	// O(log^2(n)) span
 	template<typename T, typename Comparator>
@@ -143,7 +241,7 @@ namespace Yui
 			for (size_t buffer_idx = 0; buffer_idx < array_1_size + array_2_size; ++buffer_idx)
 				*(it_array_1 + buffer_idx) = buffer[buffer_idx];
 
-		delete buffer;
+		delete[] buffer;
 	}
 
 	template<typename T, typename U, typename Comparator>
@@ -189,16 +287,213 @@ namespace Yui
 		}
 	}
 
+	// Tournament tree over k sorted ranges in which each internal node stores the index of the range which lost the match
+	// played at that node, and node 0 the overall winner. Popping the winner only replays the matches on the path from its
+	// leaf to the root, i.e. log2(k) comparisons against the stored losers and no comparison between siblings.
+	// Ties are won by the range of lowest index, which makes the merge stable.
+	template<typename T, typename Comparator>
+	class LoserTree
+	{
+	private:
+		std::vector<std::pair<T, T>> ranges_;
+		std::vector<int> tree_;
+		// Number of leaves, that is to say the number of ranges rounded up to a power of 2
+		int num_leaves_;
+		Comparator comparator_;
+
+		inline bool IsExhausted(int range)	const	{ return range >= int(ranges_.size()) || ranges_[range].first == ranges_[range].second; }
+
+		// Returns true if the current element of range a goes before the current element of range b.
+		// Exhausted ranges lose all their matches.
+		inline bool Beats(int a, int b)
+		{
+			if (IsExhausted(a))
+				return false;
+			if (IsExhausted(b))
+				return true;
+			if (comparator_(*ranges_[b].first, *ranges_[a].first))
+				return false;
+			return a < b || comparator_(*ranges_[a].first, *ranges_[b].first);
+		}
+
+		// Plays the matches of the subtree rooted at 'node' and returns the winner
+		int Initialize(int node)
+		{
+			if (node >= num_leaves_)
+				return node - num_leaves_;
+			int winner_1 = Initialize(node << 1);
+			int winner_2 = Initialize((node << 1) + 1);
+			if (Beats(winner_1, winner_2))
+			{
+				tree_[node] = winner_2;
+				return winner_1;
+			}
+			tree_[node] = winner_1;
+			return winner_2;
+		}
+
+	public:
+		LoserTree(const std::vector<std::pair<T, T>> &ranges, Comparator comparator) : ranges_(ranges), num_leaves_(1), comparator_(comparator)
+		{
+			while (num_leaves_ < int(ranges_.size()))
+				num_leaves_ <<= 1;
+			tree_.resize(num_leaves_);
+			tree_[0] = Initialize(1);
+		}
+
+		inline bool IsEmpty()	const	{ return IsExhausted(tree_[0]); }
+		// Returns an iterator on the smallest element among all the ranges
+		inline T Top()	const	{ return ranges_[tree_[0]].first; }
+
+		// Removes the smallest element from its range and replays the matches it took part in
+		void Pop()
+		{
+			int winner = tree_[0];
+			++ranges_[winner].first;
+			for (int node = (winner + num_leaves_) >> 1; node > 0; node >>= 1)
+			{
+				if (Beats(tree_[node], winner))
+					std::swap(tree_[node], winner);
+			}
+			tree_[0] = winner;
+		}
+	};
+
+	// Stable merge of the sorted ranges [ranges[i].first, ranges[i].second) into it_output with a loser tree.
+	// O(n*log(k)) time for n elements in k ranges, in a single pass, where pairwise merging would need log2(k) passes.
+	template<typename T, typename U, typename Comparator>
+	U MultiwayMerge(const std::vector<std::pair<T, T>> &ranges, U it_output, Comparator comparator)
+	{
+		if (ranges.empty())
+			return it_output;
+		LoserTree<T, Comparator> loser_tree(ranges, comparator);
+		while (!loser_tree.IsEmpty())
+		{
+			*it_output = *loser_tree.Top();
+			++it_output;
+			loser_tree.Pop();
+		}
+		return it_output;
+	}
+
+	template<typename T, typename U>
+	U MultiwayMerge(const std::vector<std::pair<T, T>> &ranges, U it_output)
+	{
+		return MultiwayMerge(ranges, it_output, IsLess<typename std::iterator_traits<T>::value_type>);
+	}
+
+	// Multi-sequence selection: finds the positions splits[i] in each sorted range such that the 'rank' first elements of the
+	// stable merge of the ranges are exactly the elements before splits[i] in each range i.
+	// At each step, the middle element of the widest remaining interval of positions is used as a pivot and the number of
+	// elements going before it in the merge is counted in every range by binary search. This halves the interval of the pivot
+	// range and narrows the others, hence O(k^2*log^2(n)) comparisons for k ranges.
+	template<typename T, typename Comparator>
+	void MultiSequenceSelect(const std::vector<std::pair<T, T>> &ranges, size_t rank, Comparator comparator, std::vector<T> &splits)
+	{
+		size_t num_ranges = ranges.size();
+		std::vector<size_t> low(num_ranges, 0);
+		std::vector<size_t> high(num_ranges);
+		for (size_t i = 0; i < num_ranges; ++i)
+			high[i] = ranges[i].second - ranges[i].first;
+		std::vector<size_t> counts(num_ranges);
+		while (true)
+		{
+			size_t pivot_range = 0;
+			for (size_t i = 1; i < num_ranges; ++i)
+			{
+				if (high[i] - low[i] > high[pivot_range] - low[pivot_range])
+					pivot_range = i;
+			}
+			if (num_ranges == 0 || high[pivot_range] == low[pivot_range])
+				break;
+			size_t pivot_position = (low[pivot_range] + high[pivot_range]) >> 1;
+			T it_pivot = ranges[pivot_range].first + pivot_position;
+
+			// Count the elements which go before the pivot in the stable merge, pivot included
+			size_t count = 0;
+			for (size_t i = 0; i < num_ranges; ++i)
+			{
+				size_t range_size = ranges[i].second - ranges[i].first;
+				if (i == pivot_range)
+					counts[i] = pivot_position + 1;
+				else if (i < pivot_range)
+					counts[i] = UpperBinarySearch(*it_pivot, ranges[i].first, range_size, comparator) - ranges[i].first;
+				else
+					counts[i] = BinarySearch(*it_pivot, ranges[i].first, range_size, comparator) - ranges[i].first;
+				count += counts[i];
+			}
+
+			if (count <= rank)
+			{
+				// The pivot and all the elements before it are among the 'rank' first elements
+				for (size_t i = 0; i < num_ranges; ++i)
+					low[i] = std::min(high[i], std::max(low[i], counts[i]));
+			}
+			else
+			{
+				// The pivot and all the elements after it are not
+				for (size_t i = 0; i < num_ranges; ++i)
+					high[i] = std::max(low[i], std::min(high[i], i == pivot_range ? pivot_position : counts[i]));
+			}
+		}
+		splits.resize(num_ranges);
+		for (size_t i = 0; i < num_ranges; ++i)
+			splits[i] = ranges[i].first + low[i];
+	}
+
+	// Parallel stable merge of the sorted ranges into it_output. The output is split into 'threads' slices of equal size whose
+	// boundaries are found in every input range by Yui::MultiSequenceSelect, then each thread merges its slice independently.
+	template<typename T, typename U, typename Comparator>
+	U PMultiwayMerge(const std::vector<std::pair<T, T>> &ranges, U it_output, Comparator comparator, unsigned int threads)
+	{
+		size_t num_elements = 0;
+		for (size_t i = 0; i < ranges.size(); ++i)
+			num_elements += ranges[i].second - ranges[i].first;
+		if (threads <= 1 || num_elements < __MERGE_SORT_GRANULARITY * threads)
+			return MultiwayMerge(ranges, it_output, comparator);
+
+		// splits[t] holds the positions in each range where the slice of thread t begins
+		std::vector<std::vector<T>> splits(threads + 1);
+#pragma omp parallel for num_threads(threads)
+		for (int t = 1; t < int(threads); ++t)
+			MultiSequenceSelect(ranges, num_elements * t / threads, comparator, splits[t]);
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			splits[0].push_back(ranges[i].first);
+			splits[threads].push_back(ranges[i].second);
+		}
+
+#pragma omp parallel for num_threads(threads)
+		for (int t = 0; t < int(threads); ++t)
+		{
+			std::vector<std::pair<T, T>> slice(ranges.size());
+			for (size_t i = 0; i < ranges.size(); ++i)
+				slice[i] = std::make_pair(splits[t][i], splits[t + 1][i]);
+			MultiwayMerge(slice, it_output + num_elements * t / threads, comparator);
+		}
+		return it_output + num_elements;
+	}
+
+	template<typename T, typename U>
+	U PMultiwayMerge(const std::vector<std::pair<T, T>> &ranges, U it_output, unsigned int threads)
+	{
+		return PMultiwayMerge(ranges, it_output, IsLess<typename std::iterator_traits<T>::value_type>, threads);
+	}
+
 	// Sort the elements between the iterators it_begin and it_end inclusive
 	template<typename T, typename Comparator>
 	T InternalMergeSort(T it_begin, T it_end, Comparator comparator, unsigned int threads)
 	{
 		int range = it_end - it_begin;
-		if (range == 0)
+		// A single element, or an empty range (it_end == it_begin - 1) whose it_begin must not be dereferenced
+		if (range <= 0)
 			return it_begin;
 		if (range < __MERGE_SORT_GRANULARITY)
 		{
-			std::sort(it_begin, it_end + 1);
+			// Vectorized sorting network for primitive types ordered by operator<
+			if (!(IsContiguousIterator<T>() && AscendingComparator<T::value_type, Comparator>::Is(comparator)
+				&& SortingNetworkSort(&*it_begin, range + 1)))
+				std::sort(it_begin, it_end + 1, comparator);
 			return it_begin;
 		}
 		T it_middle = it_begin + (range >> 1);
@@ -265,6 +560,345 @@ namespace Yui
 	{
 		MergeSort(it_begin, it_end, IsLess<T::value_type>, threads);
 	}
+
+	// Stores the splitters of the buckets [bucket_begin, bucket_end) in the implicit binary search tree 'tree' rooted at 'node',
+	// the children of node i being 2i and 2i+1. splitters[b] is the smallest element of bucket b, for b >= 1.
+	template<typename Value>
+	void BuildClassifierTree(const std::vector<Value> &splitters, std::vector<Value> &tree, size_t node, size_t bucket_begin, size_t bucket_end)
+	{
+		if (bucket_end - bucket_begin < 2)
+			return;
+		size_t bucket_middle = (bucket_begin + bucket_end) >> 1;
+		tree[node] = splitters[bucket_middle];
+		BuildClassifierTree(splitters, tree, node << 1, bucket_begin, bucket_middle);
+		BuildClassifierTree(splitters, tree, (node << 1) + 1, bucket_middle, bucket_end);
+	}
+
+	// Parallel sample sort of the elements between it_begin and it_end-1 inclusive:
+	// 1. __SAMPLE_SORT_NUM_BUCKETS-1 splitters are picked from a sorted random sample and stored in a classifier tree.
+	//    When neighbouring splitters are equal (many duplicate keys), the distinct splitters are kept in a tree of half as many
+	//    buckets and each bucket is preceded by an equality bucket receiving the elements equal to its splitter, as in IPS4o.
+	// 2. Each thread finds the bucket of the elements of its chunk by descending the tree without branching on the comparison,
+	//    and counts the elements of each bucket.
+	// 3. The elements are moved once to their bucket in a buffer, at the offsets given by the prefix sum of the histograms.
+	// 4. The buckets are sorted independently in parallel and moved back. Equality buckets are already sorted. Buckets of
+	//    more than twice the expected size are sorted afterwards by a recursive Yui::SampleSort using all the threads.
+	// The input is thus read and written about twice, instead of log2(n/__MERGE_SORT_GRANULARITY) times for Yui::MergeSort.
+	template<typename T, typename Comparator>
+	void SampleSort(T it_begin, T it_end, Comparator comparator, unsigned int threads)
+	{
+		typedef typename std::iterator_traits<T>::value_type Value;
+		const int kNumBuckets = __SAMPLE_SORT_NUM_BUCKETS;
+		static_assert(kNumBuckets >= 2 && kNumBuckets <= 256 && (kNumBuckets & (kNumBuckets - 1)) == 0,
+			"__SAMPLE_SORT_NUM_BUCKETS must be a power of 2 between 2 and 256");
+
+		int num_elements = it_end - it_begin;
+		if (num_elements < __SAMPLE_SORT_GRANULARITY)
+		{
+			if (num_elements > 1)
+				MergeSort(it_begin, it_end, comparator, threads);
+			return;
+		}
+		if (threads == 0)
+			threads = 1;
+		int num_levels = 0;
+		while ((1 << num_levels) < kNumBuckets)
+			++num_levels;
+
+		// Pick the splitters
+		std::vector<Value> sample;
+		sample.reserve(kNumBuckets * __SAMPLE_SORT_OVERSAMPLING);
+		std::mt19937 generator(num_elements);
+		for (int i = 0; i < kNumBuckets * __SAMPLE_SORT_OVERSAMPLING; ++i)
+			sample.push_back(*(it_begin + generator() % num_elements));
+		std::sort(sample.begin(), sample.end(), comparator);
+		std::vector<Value> splitters(kNumBuckets);
+		bool equality_buckets = false;
+		for (int bucket = 1; bucket < kNumBuckets; ++bucket)
+		{
+			splitters[bucket] = sample[bucket * __SAMPLE_SORT_OVERSAMPLING];
+			if (bucket > 1 && !comparator(splitters[bucket - 1], splitters[bucket]))
+				equality_buckets = true;
+		}
+		// Number of buckets of the tree, each one but the first preceded by an equality bucket when equality_buckets is set
+		int num_buckets = kNumBuckets;
+		if (equality_buckets)
+		{
+			std::vector<Value> distinct(1, splitters[1]);
+			for (int bucket = 2; bucket < kNumBuckets; ++bucket)
+				if (comparator(distinct.back(), splitters[bucket]))
+					distinct.push_back(splitters[bucket]);
+			num_buckets = kNumBuckets >> 1;
+			--num_levels;
+			// Keep at most num_buckets-1 distinct splitters, evenly spaced. When there are less, the last one is repeated,
+			// which leaves the buckets between the copies empty.
+			size_t num_distinct = distinct.size();
+			for (int bucket = 1; bucket < num_buckets; ++bucket)
+				splitters[bucket] = distinct[num_distinct < size_t(num_buckets) ? std::min<size_t>(bucket - 1, num_distinct - 1)
+					: (bucket - 1) * num_distinct / (num_buckets - 1)];
+		}
+		std::vector<Value> tree(num_buckets);
+		BuildClassifierTree(splitters, tree, 1, 0, num_buckets);
+
+		std::vector<unsigned char> bucket_ids(num_elements);
+		std::vector<size_t> histograms(threads * kNumBuckets);
+		std::vector<size_t> bucket_begin(kNumBuckets + 1);
+		std::vector<Value> buffer(num_elements);
+		size_t max_bucket_size = 2 * size_t(num_elements) / kNumBuckets;
+#pragma omp parallel num_threads(threads)
+		{
+			int num_threads = omp_get_num_threads();
+			int thread = omp_get_thread_num();
+			int chunk_begin = int((long long)(num_elements)* thread / num_threads);
+			int chunk_end = int((long long)(num_elements)* (thread + 1) / num_threads);
+			size_t *histogram = &histograms[thread * kNumBuckets];
+			std::fill(histogram, histogram + kNumBuckets, 0);
+
+			// Classification
+			for (int i = chunk_begin; i < chunk_end; ++i)
+			{
+				size_t node = 1;
+				for (int level = 0; level < num_levels; ++level)
+					node = (node << 1) + size_t(!comparator(*(it_begin + i), tree[node]));
+				size_t bucket = node - num_buckets;
+				// The element is not less than the splitter of its bucket, so it is equal to it if it is not greater. The
+				// equality bucket 2b-1 of bucket b is placed before the bucket 2b of the elements greater than the splitter.
+				if (equality_buckets)
+					bucket = (bucket << 1) - size_t(bucket > 0 && !comparator(splitters[bucket], *(it_begin + i)));
+				bucket_ids[i] = (unsigned char)bucket;
+				++histogram[bucket];
+			}
+#pragma omp barrier
+#pragma omp single
+			{
+				size_t offset = 0;
+				for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+				{
+					bucket_begin[bucket] = offset;
+					for (int t = 0; t < num_threads; ++t)
+					{
+						size_t count = histograms[t * kNumBuckets + bucket];
+						histograms[t * kNumBuckets + bucket] = offset;
+						offset += count;
+					}
+				}
+				bucket_begin[kNumBuckets] = offset;
+			}
+
+			// Distribution
+			for (int i = chunk_begin; i < chunk_end; ++i)
+				buffer[histogram[bucket_ids[i]]++] = std::move(*(it_begin + i));
+#pragma omp barrier
+
+			// Sort each bucket while it is in cache
+#pragma omp for schedule(dynamic)
+			for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+			{
+				if (bucket_begin[bucket + 1] > bucket_begin[bucket] && !(equality_buckets && (bucket & 1))
+					&& bucket_begin[bucket + 1] - bucket_begin[bucket] <= max_bucket_size)
+					InternalMergeSort(buffer.begin() + bucket_begin[bucket], buffer.begin() + (bucket_begin[bucket + 1] - 1), comparator, 1);
+				std::move(buffer.begin() + bucket_begin[bucket], buffer.begin() + bucket_begin[bucket + 1], it_begin + bucket_begin[bucket]);
+			}
+		}
+
+		// A skewed input would leave a single thread sorting a large bucket, so these are split again with all the threads.
+		// Each recursion sorts strictly fewer elements since the splitters are elements of the input.
+		for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+			if (!(equality_buckets && (bucket & 1)) && bucket_begin[bucket + 1] - bucket_begin[bucket] > max_bucket_size)
+				SampleSort(it_begin + bucket_begin[bucket], it_begin + bucket_begin[bucket + 1], comparator, threads);
+	}
+
+	// Sorts the elements between it_begin and it_end-1 inclusive in increasing order. Falls back to Yui::MergeSort when there are
+	// less than __SAMPLE_SORT_GRANULARITY elements.
+	template<typename T>
+	void SampleSort(T it_begin, T it_end, unsigned int threads = 1)
+	{
+		// std::less is inlined in the classification loop, contrary to a function pointer
+		SampleSort(it_begin, it_end, std::less<typename std::iterator_traits<T>::value_type>(), threads);
+	}
+
+	// Returns the digit of 'key' starting at bit 'shift'. Signed keys have their sign bit flipped so that negative keys
+	// are ordered before positive ones.
+	template<typename Key>
+	inline size_t RadixDigit(Key key, unsigned int shift)
+	{
+		typedef typename std::make_unsigned<Key>::type UnsignedKey;
+		UnsignedKey unsigned_key = UnsignedKey(key);
+		if (std::is_signed<Key>::value)
+			unsigned_key ^= UnsignedKey(UnsignedKey(1) << (sizeof(Key) * 8 - 1));
+		return size_t((unsigned_key >> shift) & ((1 << __RADIX_SORT_DIGIT_BITS) - 1));
+	}
+
+	// Stable counting sort of the num_elements elements at it_source into it_destination with regards to the digit starting at
+	// bit 'shift'. Each thread counts the digits of its own chunk, then scatters the chunk at the offsets obtained from the
+	// prefix sum of the histograms of all the threads, so no synchronization is needed during the scatter.
+	// Returns false without moving anything if all the elements share the same digit.
+	template<typename T, typename U, typename KeyExtractor>
+	bool RadixSortPass(T it_source, U it_destination, int num_elements, unsigned int shift, KeyExtractor &key_extractor,
+		std::vector<size_t> &histograms, unsigned int threads)
+	{
+		const int kNumBuckets = 1 << __RADIX_SORT_DIGIT_BITS;
+		bool skip_pass = false;
+#pragma omp parallel num_threads(threads)
+		{
+			int num_threads = omp_get_num_threads();
+			int thread = omp_get_thread_num();
+			int chunk_begin = int((long long)(num_elements)* thread / num_threads);
+			int chunk_end = int((long long)(num_elements)* (thread + 1) / num_threads);
+			size_t *histogram = &histograms[thread * kNumBuckets];
+			std::fill(histogram, histogram + kNumBuckets, 0);
+			for (int i = chunk_begin; i < chunk_end; ++i)
+				++histogram[RadixDigit(key_extractor(*(it_source + i)), shift)];
+#pragma omp barrier
+#pragma omp single
+			{
+				size_t offset = 0;
+				for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+				{
+					size_t bucket_size = 0;
+					for (int t = 0; t < num_threads; ++t)
+					{
+						size_t count = histograms[t * kNumBuckets + bucket];
+						histograms[t * kNumBuckets + bucket] = offset;
+						offset += count;
+						bucket_size += count;
+					}
+					if (bucket_size == size_t(num_elements))
+						skip_pass = true;
+				}
+			}
+			if (!skip_pass)
+			{
+				for (int i = chunk_begin; i < chunk_end; ++i)
+				{
+					size_t &offset = histogram[RadixDigit(key_extractor(*(it_source + i)), shift)];
+					*(it_destination + offset) = std::move(*(it_source + i));
+					++offset;
+				}
+			}
+		}
+		return !skip_pass;
+	}
+
+	// Least significant digit radix sort of the elements between it_begin and it_end-1 inclusive, ordered by the integral key
+	// returned by key_extractor(element). Stable. O(n*sizeof(key)) work with n extra elements of storage.
+	// Passes in which all the keys share the same digit are skipped.
+	template<typename T, typename KeyExtractor>
+	void RadixSort(T it_begin, T it_end, KeyExtractor key_extractor, unsigned int threads)
+	{
+		typedef typename std::iterator_traits<T>::value_type Value;
+		typedef typename std::decay<decltype(key_extractor(*it_begin))>::type Key;
+		static_assert(std::is_integral<Key>::value, "Yui::RadixSort requires integral keys");
+
+		int num_elements = it_end - it_begin;
+		// std::stable_sort keeps the sort stable on small ranges too
+		if (num_elements < __RADIX_SORT_GRANULARITY)
+		{
+			std::stable_sort(it_begin, it_end, [&key_extractor](const Value &a, const Value &b) { return key_extractor(a) < key_extractor(b); });
+			return;
+		}
+		if (threads == 0)
+			threads = 1;
+
+		std::vector<Value> buffer(num_elements);
+		std::vector<size_t> histograms(threads << __RADIX_SORT_DIGIT_BITS);
+		// Whether the sorted elements currently are in 'buffer' rather than in the input range
+		bool in_buffer = false;
+		for (unsigned int shift = 0; shift < sizeof(Key) * 8; shift += __RADIX_SORT_DIGIT_BITS)
+		{
+			if (in_buffer)
+			{
+				if (RadixSortPass(buffer.begin(), it_begin, num_elements, shift, key_extractor, histograms, threads))
+					in_buffer = false;
+			}
+			else if (RadixSortPass(it_begin, buffer.begin(), num_elements, shift, key_extractor, histograms, threads))
+				in_buffer = true;
+		}
+		if (in_buffer)
+		{
+#pragma omp parallel for num_threads(threads)
+			for (int i = 0; i < num_elements; ++i)
+				*(it_begin + i) = std::move(buffer[i]);
+		}
+	}
+
+	template<typename T>
+	inline T IdentityKey(T key)
+	{
+		return key;
+	}
+
+	// Sorts the integers between it_begin and it_end-1 inclusive in increasing order. Falls back to std::stable_sort when there
+	// are less than __RADIX_SORT_GRANULARITY elements.
+	template<typename T>
+	void RadixSort(T it_begin, T it_end, unsigned int threads = 1)
+	{
+		RadixSort(it_begin, it_end, IdentityKey<typename std::iterator_traits<T>::value_type>, threads);
+	}
+
+	// Returns the byte of s at position 'depth' (characters are read most significant byte first) shifted by 1,
+	// or 0 if s is shorter than 'depth' bytes, so that a string is ordered before all the strings it is a prefix of.
+	template<typename String>
+	inline size_t StringRadixDigit(const String &s, size_t depth)
+	{
+		typedef typename String::value_type Character;
+		typedef typename std::make_unsigned<Character>::type UnsignedCharacter;
+		size_t character_idx = depth / sizeof(Character);
+		if (character_idx >= s.length())
+			return 0;
+		unsigned int shift = (unsigned int)((sizeof(Character) - 1 - depth % sizeof(Character)) * 8);
+		return size_t((UnsignedCharacter(s[character_idx]) >> shift) & 0xFF) + 1;
+	}
+
+	// Sorts the strings between it_begin and it_end-1 inclusive, all of them sharing their first 'depth' bytes.
+	// 'it_buffer' points on a scratch area of the same size as the range to sort.
+	template<typename T, typename U>
+	void InternalMSDRadixSort(T it_begin, T it_end, U it_buffer, size_t depth, unsigned int threads)
+	{
+		const int kNumBuckets = 257;
+		int num_elements = it_end - it_begin;
+		if (num_elements < __RADIX_SORT_GRANULARITY)
+		{
+			std::sort(it_begin, it_end);
+			return;
+		}
+
+		size_t bucket_begin[kNumBuckets + 1] = { 0 };
+		for (T it = it_begin; it < it_end; ++it)
+			++bucket_begin[StringRadixDigit(*it, depth) + 1];
+		for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+			bucket_begin[bucket + 1] += bucket_begin[bucket];
+
+		// Scatter the strings into the buffer and move them back, bucket by bucket
+		size_t offsets[kNumBuckets];
+		std::copy(bucket_begin, bucket_begin + kNumBuckets, offsets);
+		for (T it = it_begin; it < it_end; ++it)
+			*(it_buffer + offsets[StringRadixDigit(*it, depth)]++) = std::move(*it);
+		std::move(it_buffer, it_buffer + num_elements, it_begin);
+
+		// Bucket 0 holds the strings of exactly 'depth' bytes which are all equal, hence already sorted
+		if (threads > 1)
+		{
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+			for (int bucket = 1; bucket < kNumBuckets; ++bucket)
+				InternalMSDRadixSort(it_begin + bucket_begin[bucket], it_begin + bucket_begin[bucket + 1], it_buffer + bucket_begin[bucket], depth + 1, 1);
+		}
+		else
+		{
+			for (int bucket = 1; bucket < kNumBuckets; ++bucket)
+				InternalMSDRadixSort(it_begin + bucket_begin[bucket], it_begin + bucket_begin[bucket + 1], it_buffer + bucket_begin[bucket], depth + 1, 1);
+		}
+	}
+
+	// Most significant digit radix sort of the std::basic_string objects between it_begin and it_end-1 inclusive, in lexicographic
+	// order. Buckets smaller than __RADIX_SORT_GRANULARITY are sorted with std::sort. The buckets of the first character byte are
+	// sorted in parallel. The sorted output can be fed in order to Yui::RadixTree::Insert.
+	template<typename T>
+	void MSDRadixSort(T it_begin, T it_end, unsigned int threads = 1)
+	{
+		std::vector<typename std::iterator_traits<T>::value_type> buffer(it_end - it_begin);
+		InternalMSDRadixSort(it_begin, it_end, buffer.begin(), 0, threads);
+	}
 };
 
 #endif
\ No newline at end of file
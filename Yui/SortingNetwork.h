@@ -0,0 +1,318 @@
+#ifndef __SORTING_NETWORK_H__
+#define __SORTING_NETWORK_H__
+
+// Vectorized sorting networks and bitonic merge kernels for small blocks of int, float and long long.
+// Yui::SortingNetworkSort sorts a block in three steps:
+// 1. The block is loaded in W registers of W lanes, and each column is sorted by an odd-even sorting network made of
+//    vertical min/max instructions only, where W is the number of lanes of a 128-bit register.
+// 2. The W registers are transposed, so that each of them holds a sorted run of W elements.
+// 3. The runs are merged two by two with Yui::SortingNetworkMerge until a single run is left.
+// Yui::SortingNetworkMerge merges two sorted arrays W elements at a time with a bitonic merge network: the next W elements
+// of the input are merged in registers with the W largest elements merged so far, and the W smallest ones are output.
+// The kernels are selected at runtime according to the features of the CPU (SSE2 for float, SSE4.2 for int and long long).
+// Both functions return false when the type or the CPU is not supported, in which case the caller must fall back to a scalar
+// implementation. NaN floats are not supported.
+#include <algorithm>
+#include <limits>
+#include <stddef.h>
+
+#ifndef __SORTING_NETWORK_MAX_ELEMENTS
+// Yui::SortingNetworkSort only sorts blocks of at most __SORTING_NETWORK_MAX_ELEMENTS elements
+#define __SORTING_NETWORK_MAX_ELEMENTS 256
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define __SORTING_NETWORK_SIMD
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define __SORTING_NETWORK_SSE42
+#else
+#include <cpuid.h>
+// GCC and Clang only emit SSE4 instructions in functions compiled for that target
+#define __SORTING_NETWORK_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace Yui
+{
+	// Unsupported types: the caller falls back to a scalar implementation
+	template<typename T>
+	inline bool SortingNetworkSort(T *data, int num_elements)
+	{
+		return false;
+	}
+
+	template<typename T>
+	inline bool SortingNetworkMerge(const T *array_1, size_t array_1_size, const T *array_2, size_t array_2_size, T *output)
+	{
+		return false;
+	}
+
+#ifdef __SORTING_NETWORK_SIMD
+	namespace SortingNetwork
+	{
+		// Returns true if the CPU supports SSE4.2 (required for 64-bit integer comparisons)
+		inline bool HasSSE42()
+		{
+			static const bool has_sse42 = []()
+			{
+#ifdef _MSC_VER
+				int registers[4];
+				__cpuid(registers, 1);
+				return (registers[2] & (1 << 20)) != 0;
+#else
+				unsigned int eax, ebx, ecx, edx;
+				if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+					return false;
+				return (ecx & (1 << 20)) != 0;
+#endif
+			}();
+			return has_sse42;
+		}
+
+		// Register operations on 4 lanes of int
+		struct Int32Lanes
+		{
+			typedef int Element;
+			static const int kNumLanes = 4;
+			static __SORTING_NETWORK_SSE42 inline __m128i Min(__m128i a, __m128i b)	{ return _mm_min_epi32(a, b); }
+			static __SORTING_NETWORK_SSE42 inline __m128i Max(__m128i a, __m128i b)	{ return _mm_max_epi32(a, b); }
+			static inline bool IsSupported()	{ return HasSSE42(); }
+		};
+
+		// Register operations on 4 lanes of float. The lanes are kept in integer registers and only reinterpreted for min/max.
+		struct FloatLanes
+		{
+			typedef float Element;
+			static const int kNumLanes = 4;
+			static __SORTING_NETWORK_SSE42 inline __m128i Min(__m128i a, __m128i b)	{ return _mm_castps_si128(_mm_min_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+			static __SORTING_NETWORK_SSE42 inline __m128i Max(__m128i a, __m128i b)	{ return _mm_castps_si128(_mm_max_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+			// min/max_ps are SSE, but the networks using these lanes are compiled for SSE4.2
+			static inline bool IsSupported()	{ return HasSSE42(); }
+		};
+
+		// Register operations on 2 lanes of long long
+		struct Int64Lanes
+		{
+			typedef long long Element;
+			static const int kNumLanes = 2;
+			static __SORTING_NETWORK_SSE42 inline __m128i Min(__m128i a, __m128i b)	{ return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b)); }
+			static __SORTING_NETWORK_SSE42 inline __m128i Max(__m128i a, __m128i b)	{ return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b)); }
+			static inline bool IsSupported()	{ return HasSSE42(); }
+		};
+
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 inline void CompareExchange(__m128i &a, __m128i &b)
+		{
+			__m128i min = Lanes::Min(a, b);
+			b = Lanes::Max(a, b);
+			a = min;
+		}
+
+		// Merges the sorted registers a and b: a receives the 4 smallest elements and b the 4 largest ones, both sorted.
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 inline void BitonicMerge4(__m128i &a, __m128i &b)
+		{
+			// a followed by reversed b is a bitonic sequence
+			b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 1, 2, 3));
+			// Compare the elements at distance 4, then 2, then 1
+			__m128i low = Lanes::Min(a, b);
+			__m128i high = Lanes::Max(a, b);
+			__m128i x = _mm_unpacklo_epi64(low, high);
+			__m128i y = _mm_unpackhi_epi64(low, high);
+			CompareExchange<Lanes>(x, y);
+			__m128i lo = _mm_unpacklo_epi32(x, y);
+			__m128i hi = _mm_unpackhi_epi32(x, y);
+			x = _mm_unpacklo_epi64(lo, hi);
+			y = _mm_unpackhi_epi64(lo, hi);
+			CompareExchange<Lanes>(x, y);
+			a = _mm_unpacklo_epi32(x, y);
+			b = _mm_unpackhi_epi32(x, y);
+		}
+
+		// Merges the sorted registers a and b: a receives the 2 smallest elements and b the 2 largest ones, both sorted.
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 inline void BitonicMerge2(__m128i &a, __m128i &b)
+		{
+			b = _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2));
+			__m128i low = Lanes::Min(a, b);
+			__m128i high = Lanes::Max(a, b);
+			__m128i x = _mm_unpacklo_epi64(low, high);
+			__m128i y = _mm_unpackhi_epi64(low, high);
+			CompareExchange<Lanes>(x, y);
+			a = _mm_unpacklo_epi64(x, y);
+			b = _mm_unpackhi_epi64(x, y);
+		}
+
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 inline void BitonicMerge(__m128i &a, __m128i &b)
+		{
+			if (Lanes::kNumLanes == 4)
+				BitonicMerge4<Lanes>(a, b);
+			else
+				BitonicMerge2<Lanes>(a, b);
+		}
+
+		template<typename T>
+		__SORTING_NETWORK_SSE42 inline __m128i Load(const T *p)	{ return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+		template<typename T>
+		__SORTING_NETWORK_SSE42 inline void Store(T *p, __m128i v)	{ _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+
+		// Merges array_1 and array_2 into output. Both arrays must hold at least Lanes::kNumLanes elements.
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 void MergeArrays(const typename Lanes::Element *array_1, size_t array_1_size,
+			const typename Lanes::Element *array_2, size_t array_2_size, typename Lanes::Element *output)
+		{
+			typedef typename Lanes::Element Element;
+			const size_t kNumLanes = Lanes::kNumLanes;
+			size_t i = kNumLanes;
+			size_t j = kNumLanes;
+			__m128i low = Load(array_1);
+			__m128i high = Load(array_2);
+			BitonicMerge<Lanes>(low, high);
+			Store(output, low);
+			output += kNumLanes;
+			// 'high' holds the kNumLanes largest elements merged so far. The next block comes from the array whose next element
+			// is the smallest, so that all the elements output after merging it with 'high' are smaller than the remaining ones.
+			while (i + kNumLanes <= array_1_size && j + kNumLanes <= array_2_size)
+			{
+				if (array_1[i] < array_2[j])
+				{
+					low = Load(array_1 + i);
+					i += kNumLanes;
+				}
+				else
+				{
+					low = Load(array_2 + j);
+					j += kNumLanes;
+				}
+				BitonicMerge<Lanes>(low, high);
+				Store(output, low);
+				output += kNumLanes;
+			}
+
+			// Scalar 3-way merge of 'high' with the tails of both arrays
+			Element carry[4];
+			Store(carry, high);
+			size_t k = 0;
+			while (k < kNumLanes || i < array_1_size || j < array_2_size)
+			{
+				if (k < kNumLanes && (i == array_1_size || !(array_1[i] < carry[k])) && (j == array_2_size || !(array_2[j] < carry[k])))
+					*output++ = carry[k++];
+				else if (i < array_1_size && (j == array_2_size || !(array_2[j] < array_1[i])))
+					*output++ = array_1[i++];
+				else
+					*output++ = array_2[j++];
+			}
+		}
+
+		// Sorts num_elements <= __SORTING_NETWORK_MAX_ELEMENTS elements of data
+		template<typename Lanes>
+		__SORTING_NETWORK_SSE42 void SortBlock(typename Lanes::Element *data, int num_elements)
+		{
+			typedef typename Lanes::Element Element;
+			const int kNumLanes = Lanes::kNumLanes;
+			const int kBlockSize = kNumLanes * kNumLanes;
+			Element buffer_1[__SORTING_NETWORK_MAX_ELEMENTS + kBlockSize];
+			Element buffer_2[__SORTING_NETWORK_MAX_ELEMENTS + kBlockSize];
+
+			// Pad the last block with the largest value, which is sorted last
+			int padded_size = (num_elements + kBlockSize - 1) / kBlockSize * kBlockSize;
+			std::copy(data, data + num_elements, buffer_1);
+			Element padding = std::numeric_limits<Element>::has_infinity ? std::numeric_limits<Element>::infinity() : std::numeric_limits<Element>::max();
+			std::fill(buffer_1 + num_elements, buffer_1 + padded_size, padding);
+
+			for (int block = 0; block < padded_size; block += kBlockSize)
+			{
+				__m128i rows[4];
+				for (int r = 0; r < kNumLanes; ++r)
+					rows[r] = Load(buffer_1 + block + r * kNumLanes);
+				// Sort the columns, then transpose so that each row holds a sorted run
+				if (kNumLanes == 4)
+				{
+					CompareExchange<Lanes>(rows[0], rows[1]);
+					CompareExchange<Lanes>(rows[2], rows[3]);
+					CompareExchange<Lanes>(rows[0], rows[2]);
+					CompareExchange<Lanes>(rows[1], rows[3]);
+					CompareExchange<Lanes>(rows[1], rows[2]);
+					__m128i t0 = _mm_unpacklo_epi32(rows[0], rows[1]);
+					__m128i t1 = _mm_unpacklo_epi32(rows[2], rows[3]);
+					__m128i t2 = _mm_unpackhi_epi32(rows[0], rows[1]);
+					__m128i t3 = _mm_unpackhi_epi32(rows[2], rows[3]);
+					rows[0] = _mm_unpacklo_epi64(t0, t1);
+					rows[1] = _mm_unpackhi_epi64(t0, t1);
+					rows[2] = _mm_unpacklo_epi64(t2, t3);
+					rows[3] = _mm_unpackhi_epi64(t2, t3);
+				}
+				else
+				{
+					CompareExchange<Lanes>(rows[0], rows[1]);
+					__m128i t0 = _mm_unpacklo_epi64(rows[0], rows[1]);
+					rows[1] = _mm_unpackhi_epi64(rows[0], rows[1]);
+					rows[0] = t0;
+				}
+				for (int r = 0; r < kNumLanes; ++r)
+					Store(buffer_1 + block + r * kNumLanes, rows[r]);
+			}
+
+			// Bottom-up merge of the sorted runs, alternating between both buffers
+			Element *source = buffer_1;
+			Element *destination = buffer_2;
+			for (int run_size = kNumLanes; run_size < padded_size; run_size <<= 1)
+			{
+				for (int run = 0; run < padded_size; run += (run_size << 1))
+				{
+					if (run + run_size < padded_size)
+						MergeArrays<Lanes>(source + run, run_size, source + run + run_size, std::min(run_size, padded_size - run - run_size), destination + run);
+					else
+						std::copy(source + run, source + padded_size, destination + run);
+				}
+				std::swap(source, destination);
+			}
+			std::copy(source, source + num_elements, data);
+		}
+
+		template<typename Lanes>
+		inline bool Sort(typename Lanes::Element *data, int num_elements)
+		{
+			if (num_elements > __SORTING_NETWORK_MAX_ELEMENTS || !Lanes::IsSupported())
+				return false;
+			if (num_elements > 1)
+				SortBlock<Lanes>(data, num_elements);
+			return true;
+		}
+
+		template<typename Lanes>
+		inline bool Merge(const typename Lanes::Element *array_1, size_t array_1_size, const typename Lanes::Element *array_2, size_t array_2_size,
+			typename Lanes::Element *output)
+		{
+			if (array_1_size < size_t(Lanes::kNumLanes) || array_2_size < size_t(Lanes::kNumLanes) || !Lanes::IsSupported())
+				return false;
+			MergeArrays<Lanes>(array_1, array_1_size, array_2, array_2_size, output);
+			return true;
+		}
+	}
+
+	inline bool SortingNetworkSort(int *data, int num_elements)	{ return SortingNetwork::Sort<SortingNetwork::Int32Lanes>(data, num_elements); }
+	inline bool SortingNetworkSort(float *data, int num_elements)	{ return SortingNetwork::Sort<SortingNetwork::FloatLanes>(data, num_elements); }
+	inline bool SortingNetworkSort(long long *data, int num_elements)	{ return SortingNetwork::Sort<SortingNetwork::Int64Lanes>(data, num_elements); }
+
+	inline bool SortingNetworkMerge(const int *array_1, size_t array_1_size, const int *array_2, size_t array_2_size, int *output)
+	{
+		return SortingNetwork::Merge<SortingNetwork::Int32Lanes>(array_1, array_1_size, array_2, array_2_size, output);
+	}
+	inline bool SortingNetworkMerge(const float *array_1, size_t array_1_size, const float *array_2, size_t array_2_size, float *output)
+	{
+		return SortingNetwork::Merge<SortingNetwork::FloatLanes>(array_1, array_1_size, array_2, array_2_size, output);
+	}
+	inline bool SortingNetworkMerge(const long long *array_1, size_t array_1_size, const long long *array_2, size_t array_2_size, long long *output)
+	{
+		return SortingNetwork::Merge<SortingNetwork::Int64Lanes>(array_1, array_1_size, array_2, array_2_size, output);
+	}
+#endif
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __THREAD_LOCAL_RANDOM_H__
+#define __THREAD_LOCAL_RANDOM_H__
+
+// Per-thread pseudo-random numbers for the concurrent containers (Yui::MultiQueue, Yui::ConcurrentSkipList): each thread
+// owns its generator, so drawing a number needs neither a lock nor a shared cache line.
+
+// Storage class of per-thread variables. VS2013 does not support thread_local, but __declspec(thread) is enough for a
+// static variable of a built-in type.
+#ifdef _MSC_VER
+#define __THREAD_LOCAL	__declspec(thread)
+#else
+#define __THREAD_LOCAL	__thread
+#endif
+
+namespace Yui
+{
+	// Returns the next number of the xorshift generator of the calling thread, seeded from the address of the thread's state
+	inline unsigned long long ThreadLocalRandom()
+	{
+		static __THREAD_LOCAL unsigned long long state = 0;
+		if (state == 0)
+			state = reinterpret_cast<unsigned long long>(&state) * 0x9E3779B97F4A7C15ULL | 1;
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+};
+
+#endif